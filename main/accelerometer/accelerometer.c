@@ -3,7 +3,11 @@
 #include "freertos/semphr.h"
 #include "accelerometer.h"
 #include "i2c_bus/i2c_bus.h"
+#include "boot_metrics/boot_metrics.h"
 #include "esp_log.h"
+#include "dlog/dlog.h"
+#include "udp_exporter/udp_exporter.h"
+#include "capture/capture.h"
 
 static const char *TAG = "accelerometer";
 
@@ -46,12 +50,13 @@ static const char *TAG = "accelerometer";
 float x_g = 0;
 float y_g = 0;
 float z_g = 0;
+bool accelerometer_stale = true; // set while x_g/y_g/z_g hold an old reading
 
 /**
  * @brief Read one or more registers from the LIS3DH accelerometer.
  *
  * This function performs an I2C read with automatic register address increment.
- * It uses the global `i2c_dev_accelerometer` handle. It does NOT block other
+ * It goes through i2c_bus for error accounting and recovery. It does NOT block other
  * I2C devices automatically, so you should take `i2c_mutex` before calling it.
  *
  * @param reg  The starting register address to read from.
@@ -63,33 +68,65 @@ float z_g = 0;
 static esp_err_t lis3dh_read(uint8_t reg, uint8_t *data, size_t len)
 {
     reg |= 0x80; // auto-increment
-    return i2c_master_transmit_receive(
-        i2c_dev_accelerometer,
+    return i2c_bus_transmit_receive(
+        I2C_DEV_ACCELEROMETER,
         &reg, 1,
-        data, len,
-        50
+        data, len
     );
 }
 
 /**
  * @brief Read accelerometer data over I2C.
  *
- * Updates the global variables `x_acc`, `y_acc`, `z_acc` in g units.
+ * Updates the global variables `x_g`, `y_g`, `z_g` in g units. If the
+ * sensor can't be read they keep their previous values and
+ * `accelerometer_stale` is set.
  */
 void get_accelerometer_data(void)
 {
-    uint8_t ctrl4;
+    // CTRL4, OUT_X_L..OUT_Z_H, CLICK_SRC; see accelerometer_process_raw()
+    uint8_t raw[ACCELEROMETER_RAW_LEN];
 
     /*
     Reads the CTRL4 register of the LIS3DH. This register stores:
     - The full-scale range (±2g, ±4g, ±8g, ±16g)
     - Whether high-resolution mode is enabled.
     */
-    if (lis3dh_read(LIS3DH_REG_CTRL4, &ctrl4, 1) != ESP_OK) {
+    if (lis3dh_read(LIS3DH_REG_CTRL4, &raw[0], 1) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to read CTRL_REG4");
+        accelerometer_stale = true;
         return;
     }
 
+    if (lis3dh_read(LIS3DH_REG_OUT_X_L, &raw[1], 6) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read acceleration data");
+        accelerometer_stale = true;
+        return;
+    }
+
+    if (lis3dh_read(LIS3DH_CLICK_SRC, &raw[7], 1) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read CLICK_SRC");
+        raw[7] = 0;
+    }
+
+    capture_record(CAPTURE_SRC_ACCELEROMETER, raw, sizeof(raw));
+    accelerometer_process_raw(raw);
+}
+
+/**
+ * @brief Convert a raw register payload to g and publish it.
+ *
+ * Shared by the I2C path and capture replay, so replayed payloads go
+ * through exactly the same arithmetic.
+ *
+ * @param payload CTRL4, OUT_X_L, OUT_X_H, OUT_Y_L, OUT_Y_H, OUT_Z_L, OUT_Z_H, CLICK_SRC
+ */
+void accelerometer_process_raw(const uint8_t payload[ACCELEROMETER_RAW_LEN])
+{
+    uint8_t ctrl4 = payload[0];
+    const uint8_t *raw = &payload[1];
+    uint8_t click_src = payload[7];
+
     uint8_t range_bits = (ctrl4 >> 4) & 0x03; // Determine measurement range
     uint8_t hr_bit = (ctrl4 >> 3) & 0x01; // Bit 3 of CTRL4, indicates high-resolution mode
 
@@ -105,12 +142,6 @@ void get_accelerometer_data(void)
 
     int bits = hr_bit ? 12 : 10;
 
-    uint8_t raw[6];
-    if (lis3dh_read(LIS3DH_REG_OUT_X_L, raw, 6) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to read acceleration data");
-        return;
-    }
-
     // Combines low and high bytes into a signed 16-bit integer
     int16_t x_raw = (int16_t)(raw[0] | (raw[1] << 8));
     int16_t y_raw = (int16_t)(raw[2] | (raw[3] << 8));
@@ -128,16 +159,13 @@ void get_accelerometer_data(void)
         y_g = (float)y_raw * range_g / 32000.0f;
         z_g = (float)z_raw * range_g / 32000.0f;
     }
+    accelerometer_stale = false;
+    boot_metrics_mark_first_sample(TAG);
 
-    uint8_t click_src;
-    if (lis3dh_read(LIS3DH_CLICK_SRC, &click_src, 1) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to read CLICK_SRC");
-        return;
-    }
     // ESP_LOGI(TAG, "REG %02hhx", click_src);
 
     if (click_src & CLICK_DCLICK) {
-        ESP_LOGI(TAG, "DOUBLE click");
+        DLOGI(TAG, "DOUBLE click");
     }
     // } else if (click_src & CLICK_SCLICK) {
     //     ESP_LOGI(TAG, "SINGLE click");
@@ -162,7 +190,10 @@ void accelerometer_update_task(void *pvParameters)
         xSemaphoreTake(i2c_mutex, portMAX_DELAY);
         get_accelerometer_data();
         xSemaphoreGive(i2c_mutex);
-        ESP_LOGI(TAG, "X: %.2f g, Y: %.2f g, Z: %.2f g", x_g, y_g, z_g);
+        if (!accelerometer_stale) {
+            DLOGI(TAG, "X: %.2f g, Y: %.2f g, Z: %.2f g", x_g, y_g, z_g);
+            udp_exporter_push(UDP_EXPORTER_CH_ACCEL, (const float[]){ x_g, y_g, z_g });
+        }
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
 }
@@ -170,20 +201,23 @@ void accelerometer_update_task(void *pvParameters)
 /**
  * @brief Initialize the LIS3DH accelerometer.
  *
- * Powers on the device and set up configurations
+ * Powers on the device and set up configurations. Also registered with
+ * i2c_bus as the device's re-init routine after a bus recovery.
  */
 void accelerometer_sensor_init(void)
 {
+    i2c_bus_set_reinit(I2C_DEV_ACCELEROMETER, accelerometer_sensor_init);
+
 	{
         // Power ON and enable X/Y/Z axes
         uint8_t write_buf[] = {LIS3DH_REG_CTRL1, LIS3DH_ODR_100HZ | LIS3DH_X_ENABLE | LIS3DH_Y_ENABLE | LIS3DH_Z_ENABLE};
-        i2c_master_transmit(i2c_dev_accelerometer, write_buf, 2, 50);
+        i2c_bus_transmit(I2C_DEV_ACCELEROMETER, write_buf, 2);
     }
 
 	{
         // High-pass filter enabled for CLICK function
         uint8_t write_buf[] = {LIS3DH_REG_CTRL2, LIS3DY_HPCLICK};
-        i2c_master_transmit(i2c_dev_accelerometer, write_buf, 2, 50);
+        i2c_bus_transmit(I2C_DEV_ACCELEROMETER, write_buf, 2);
     }
 
     // {
@@ -198,7 +232,7 @@ void accelerometer_sensor_init(void)
     {
         // Double click
         uint8_t write_buf[] = {LIS3DH_CLICK_CFG, LIS3DH_CLICK_CFG_ZD};
-	    i2c_master_transmit(i2c_dev_accelerometer, write_buf, 2, 50);
+	    i2c_bus_transmit(I2C_DEV_ACCELEROMETER, write_buf, 2);
     }
 
     // {
@@ -206,30 +240,30 @@ void accelerometer_sensor_init(void)
     //     uint8_t write_buf[] = {LIS3DH_CLICK_CFG,
     //         LIS3DH_CLICK_CFG_XD | LIS3DH_CLICK_CFG_YD | LIS3DH_CLICK_CFG_ZD |
     //         LIS3DH_CLICK_CFG_XS | LIS3DH_CLICK_CFG_YS | LIS3DH_CLICK_CFG_ZS};
-    //     i2c_master_transmit(i2c_dev_accelerometer, write_buf, 2, 50);
+    //     i2c_bus_transmit(I2C_DEV_ACCELEROMETER, write_buf, 2);
     // }
 
     {
         // Click threshold
         uint8_t write_buf[] = {LIS3DH_CLICK_THS, 20 | LIS3DH_CLICK_THS_LIR_CLICK};
-	    i2c_master_transmit(i2c_dev_accelerometer, write_buf, 2, 50);
+	    i2c_bus_transmit(I2C_DEV_ACCELEROMETER, write_buf, 2);
     }
 
     {
         // Time limit
         uint8_t write_buf[] = {LIS3DH_TIME_LIMIT, 10};
-	    i2c_master_transmit(i2c_dev_accelerometer, write_buf, 2, 50);
+	    i2c_bus_transmit(I2C_DEV_ACCELEROMETER, write_buf, 2);
     }
 
     {
         // Time latency
         uint8_t write_buf[] = {LIS3DH_TIME_LATENCY, 20};
-	    i2c_master_transmit(i2c_dev_accelerometer, write_buf, 2, 50);
+	    i2c_bus_transmit(I2C_DEV_ACCELEROMETER, write_buf, 2);
     }
 
     {
         // Time window
         uint8_t write_buf[] = {LIS3DH_TIME_WINDOW, 40};
-	    i2c_master_transmit(i2c_dev_accelerometer, write_buf, 2, 50);
+	    i2c_bus_transmit(I2C_DEV_ACCELEROMETER, write_buf, 2);
     }
 }
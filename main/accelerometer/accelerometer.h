@@ -1,14 +1,19 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-extern float x_acc;
-extern float y_acc;
-extern float z_acc;
+#define ACCELEROMETER_RAW_LEN 8  /*!< CTRL4, OUT_X_L..OUT_Z_H, CLICK_SRC */
+
+extern float x_g;
+extern float y_g;
+extern float z_g;
+extern bool accelerometer_stale;
 
 /**
  * @brief FreeRTOS task that periodically reads accelerometer data.
@@ -20,6 +25,11 @@ void accelerometer_update_task(void *pvParameters);
  */
 void get_accelerometer_data();
 
+/**
+ * @brief Convert a raw register payload to g and publish it.
+ */
+void accelerometer_process_raw(const uint8_t payload[ACCELEROMETER_RAW_LEN]);
+
 /**
  * @brief Initialize the LIS3DH accelerometer.
  */
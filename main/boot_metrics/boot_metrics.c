@@ -0,0 +1,47 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "boot_metrics.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "boot_metrics";
+
+static atomic_int_least32_t first_sample_ms = -1;
+static atomic_int_least32_t got_ip_ms = -1;
+
+/**
+ * @brief Store the current uptime in `slot` unless it was already set.
+ * @return true if this call set it
+ */
+static bool mark_once(atomic_int_least32_t *slot, int32_t *now_ms)
+{
+    int_least32_t unset = -1;
+    *now_ms = (int32_t)(esp_timer_get_time() / 1000);
+    return atomic_compare_exchange_strong(slot, &unset, *now_ms);
+}
+
+void boot_metrics_mark_first_sample(const char *source)
+{
+    int32_t now_ms;
+    if (atomic_load(&first_sample_ms) < 0 && mark_once(&first_sample_ms, &now_ms)) {
+        ESP_LOGI(TAG, "Time to first sample: %ld ms (%s)", (long)now_ms, source);
+    }
+}
+
+void boot_metrics_mark_got_ip(void)
+{
+    int32_t now_ms;
+    if (atomic_load(&got_ip_ms) < 0 && mark_once(&got_ip_ms, &now_ms)) {
+        ESP_LOGI(TAG, "Time to IP: %ld ms", (long)now_ms);
+    }
+}
+
+int32_t boot_metrics_first_sample_ms(void)
+{
+    return atomic_load(&first_sample_ms);
+}
+
+int32_t boot_metrics_got_ip_ms(void)
+{
+    return atomic_load(&got_ip_ms);
+}
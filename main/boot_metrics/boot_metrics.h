@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Record that a sensor produced its first reading.
+ *
+ * Only the first call after boot is kept; later calls are cheap no-ops.
+ *
+ * @param source Name of the sensor, for the log line
+ */
+void boot_metrics_mark_first_sample(const char *source);
+
+/**
+ * @brief Record that the station obtained an IP address.
+ */
+void boot_metrics_mark_got_ip(void);
+
+/**
+ * @brief Time from boot to the first sensor reading in milliseconds, -1 if none yet
+ */
+int32_t boot_metrics_first_sample_ms(void);
+
+/**
+ * @brief Time from boot to the first IP address in milliseconds, -1 if none yet
+ */
+int32_t boot_metrics_got_ip_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,376 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "capture.h"
+#include "th_sensor/th_sensor.h"
+#include "accelerometer/accelerometer.h"
+#include "fnv1a.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_partition.h"
+#endif
+
+static const char *TAG = "capture";
+
+#define CAPTURE_HEADER_SIZE     8
+#define CAPTURE_RECORD_HEADER   6
+#define CAPTURE_STREAM_SIZE     4096    /*!< Records in flight between the sensor tasks and the writer */
+#define CAPTURE_CHUNK_SIZE      512     /*!< Largest single write to the sink */
+#define CAPTURE_FLUSH_MS        500     /*!< Longest a record waits before it is written */
+
+/*
+ * Sensor tasks push records into a stream buffer under capture_mutex (a
+ * stream buffer only supports one writer at a time); a writer task moves
+ * them to the sink, so a sampling loop never waits for a write to finish.
+ * It can still be held up while a flash operation has the cache disabled.
+ */
+static SemaphoreHandle_t capture_mutex = NULL;
+static SemaphoreHandle_t writer_idle = NULL;   /*!< Given while no writer task runs */
+static StreamBufferHandle_t stream = NULL;
+static volatile bool capturing = false;
+static int64_t last_us = 0;
+static capture_stats_t stats;
+
+#if !CONFIG_IDF_TARGET_LINUX
+static const esp_partition_t *partition = NULL;
+static size_t write_offset = 0;
+static size_t erased_end = 0;
+
+static esp_err_t sink_open(void)
+{
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, CAPTURE_PARTITION_SUBTYPE,
+                                         CONFIG_CAPTURE_PARTITION);
+    if (!partition) {
+        ESP_LOGE(TAG, "No \"%s\" data partition", CONFIG_CAPTURE_PARTITION);
+        return ESP_ERR_NOT_FOUND;
+    }
+    write_offset = 0;
+    erased_end = 0;
+    ESP_LOGI(TAG, "Capturing to partition %s (%lu KiB)", partition->label,
+             (unsigned long)(partition->size / 1024));
+    return ESP_OK;
+}
+
+/**
+ * @brief Append to the partition, erasing sectors as the data reaches them.
+ *
+ * At least one erased byte is kept after the data, so the capture always
+ * ends in CAPTURE_SRC_END even if the board resets mid-capture and older
+ * data follows.
+ */
+static esp_err_t sink_write(const void *data, size_t len)
+{
+    if (write_offset + len > partition->size) {
+        return ESP_ERR_NO_MEM;
+    }
+    while (erased_end <= write_offset + len && erased_end < partition->size) {
+        esp_err_t err = esp_partition_erase_range(partition, erased_end, partition->erase_size);
+        if (err != ESP_OK) {
+            return err;
+        }
+        erased_end += partition->erase_size;
+    }
+    esp_err_t err = esp_partition_write(partition, write_offset, data, len);
+    if (err == ESP_OK) {
+        write_offset += len;
+    }
+    return err;
+}
+
+static void sink_close(void)
+{
+    partition = NULL;
+}
+#else
+static FILE *capture_file = NULL;
+
+static esp_err_t sink_open(void)
+{
+    capture_file = fopen(CONFIG_CAPTURE_PATH, "wb");
+    if (!capture_file) {
+        ESP_LOGE(TAG, "Failed to open %s", CONFIG_CAPTURE_PATH);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Capturing to %s", CONFIG_CAPTURE_PATH);
+    return ESP_OK;
+}
+
+static esp_err_t sink_write(const void *data, size_t len)
+{
+    if (fwrite(data, 1, len, capture_file) != len || fflush(capture_file) != 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void sink_close(void)
+{
+    fclose(capture_file);
+    capture_file = NULL;
+}
+#endif
+
+static void capture_end(const char *why)
+{
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    bool was_capturing = capturing;
+    capturing = false;
+    stats.active = false;
+    xSemaphoreGive(capture_mutex);
+
+    if (was_capturing && why) {
+        ESP_LOGW(TAG, "Capture stopped: %s", why);
+    }
+}
+
+static void capture_writer_task(void *pvParameters)
+{
+    static uint8_t chunk[CAPTURE_CHUNK_SIZE];
+    int64_t deadline_us = CONFIG_CAPTURE_DURATION_S ?
+                          esp_timer_get_time() + CONFIG_CAPTURE_DURATION_S * 1000000LL : 0;
+
+    while (1) {
+        size_t n = xStreamBufferReceive(stream, chunk, sizeof(chunk), pdMS_TO_TICKS(CAPTURE_FLUSH_MS));
+        if (n > 0) {
+            esp_err_t err = sink_write(chunk, n);
+            if (err != ESP_OK) {
+                capture_end(err == ESP_ERR_NO_MEM ? "sink full" : "write failed");
+                break;
+            }
+            xSemaphoreTake(capture_mutex, portMAX_DELAY);
+            stats.bytes += n;
+            xSemaphoreGive(capture_mutex);
+        } else if (!capturing) {
+            // Stopped and everything accepted before the stop is written
+            break;
+        }
+
+        if (deadline_us && esp_timer_get_time() >= deadline_us) {
+            capture_end("time limit reached");
+        }
+    }
+
+    sink_close();
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    stats.writing = false;
+    xSemaphoreGive(capture_mutex);
+    ESP_LOGI(TAG, "Capture closed: %lu records, %lu dropped, %lu bytes",
+             (unsigned long)stats.records, (unsigned long)stats.dropped, (unsigned long)stats.bytes);
+    xSemaphoreGive(writer_idle);
+    vTaskDelete(NULL);
+}
+
+esp_err_t capture_start(void)
+{
+    if (!capture_mutex) {
+        capture_mutex = xSemaphoreCreateMutex();
+        writer_idle = xSemaphoreCreateBinary();
+        stream = xStreamBufferCreate(CAPTURE_STREAM_SIZE, 1);
+        if (!capture_mutex || !writer_idle || !stream) {
+            return ESP_ERR_NO_MEM;
+        }
+        xSemaphoreGive(writer_idle);
+    }
+
+    // Still capturing, or the previous writer is finishing up
+    if (xSemaphoreTake(writer_idle, 0) != pdTRUE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = sink_open();
+    if (err != ESP_OK) {
+        xSemaphoreGive(writer_idle);
+        return err;
+    }
+
+    xStreamBufferReset(stream);
+    memset(&stats, 0, sizeof(stats));
+    const uint8_t header[CAPTURE_HEADER_SIZE] = { 'S', 'K', 'C', 'P', CAPTURE_VERSION, 0, 0, 0 };
+    xStreamBufferSend(stream, header, sizeof(header), 0);
+
+    if (xTaskCreate(capture_writer_task, "capture", 3072, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS) {
+        sink_close();
+        xSemaphoreGive(writer_idle);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    last_us = esp_timer_get_time();
+    stats.active = true;
+    stats.writing = true;
+    capturing = true;
+    xSemaphoreGive(capture_mutex);
+    return ESP_OK;
+}
+
+void capture_stop(void)
+{
+    if (!capture_mutex) {
+        return;
+    }
+
+    // The writer sees the flag once the stream buffer is empty and exits
+    capture_end(NULL);
+}
+
+void capture_record(capture_source_t source, const uint8_t *payload, size_t len)
+{
+    if (!capturing) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    uint8_t rec[CAPTURE_RECORD_HEADER + UINT8_MAX];
+    if (len > UINT8_MAX) {
+        return;
+    }
+
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    if (capturing) {
+        size_t total = CAPTURE_RECORD_HEADER + len;
+        if (xStreamBufferSpacesAvailable(stream) < total) {
+            stats.dropped++;
+        } else {
+            int64_t dt = now_us - last_us;
+            uint32_t dt_us = dt < 0 ? 0 : dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;
+            last_us = now_us;
+
+            rec[0] = source;
+            rec[1] = len;
+            rec[2] = dt_us;
+            rec[3] = dt_us >> 8;
+            rec[4] = dt_us >> 16;
+            rec[5] = dt_us >> 24;
+            memcpy(&rec[CAPTURE_RECORD_HEADER], payload, len);
+            xStreamBufferSend(stream, rec, total, 0);
+            stats.records++;
+        }
+    }
+    xSemaphoreGive(capture_mutex);
+}
+
+void capture_get_stats(capture_stats_t *out)
+{
+    if (!capture_mutex) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(capture_mutex);
+}
+
+#if CONFIG_CAPTURE_REPLAY
+static size_t payload_len(uint8_t source)
+{
+    switch (source) {
+        case CAPTURE_SRC_TH_SENSOR:     return TH_SENSOR_RAW_LEN;
+        case CAPTURE_SRC_ACCELEROMETER: return ACCELEROMETER_RAW_LEN;
+        default:                        return 0;
+    }
+}
+
+esp_err_t capture_replay(const char *path, bool realtime, capture_replay_result_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->hash = FNV1A32_INIT;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t header[CAPTURE_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) ||
+        memcmp(header, CAPTURE_MAGIC, 4) != 0 || header[4] != CAPTURE_VERSION) {
+        ESP_LOGE(TAG, "%s is not a version %d capture", path, CAPTURE_VERSION);
+        fclose(f);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    int64_t start = esp_timer_get_time();
+    int64_t due = start;
+    uint8_t rec[CAPTURE_RECORD_HEADER];
+    uint8_t payload[UINT8_MAX];
+
+    while (fread(rec, 1, sizeof(rec), f) == sizeof(rec) && rec[0] != CAPTURE_SRC_END) {
+        uint8_t source = rec[0];
+        uint8_t len = rec[1];
+        uint32_t dt_us = rec[2] | rec[3] << 8 | rec[4] << 16 | (uint32_t)rec[5] << 24;
+        if (fread(payload, 1, len, f) != len) {
+            break;
+        }
+
+        if (realtime) {
+            due += dt_us;
+            int64_t wait_us = due - esp_timer_get_time();
+            if (wait_us > 1000) {
+                vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+            }
+        }
+
+        if (len != payload_len(source)) {
+            out->skipped++;
+            continue;
+        }
+
+        if (source == CAPTURE_SRC_TH_SENSOR) {
+            th_sensor_process_raw(payload);
+            float th[2];
+            th_sensor_get_reading(&th[0], &th[1], NULL);
+            out->hash = fnv1a32(out->hash, th, sizeof(th));
+        } else {
+            accelerometer_process_raw(payload);
+            float xyz[3] = { x_g, y_g, z_g };
+            out->hash = fnv1a32(out->hash, xyz, sizeof(xyz));
+        }
+        out->records++;
+    }
+
+    out->elapsed_us = esp_timer_get_time() - start;
+    fclose(f);
+    return ESP_OK;
+}
+
+static void capture_replay_task(void *pvParameters)
+{
+    capture_replay_result_t result;
+#if CONFIG_CAPTURE_REPLAY_REALTIME
+    bool realtime = true;
+#else
+    bool realtime = false;
+#endif
+
+    esp_err_t err = capture_replay(CONFIG_CAPTURE_REPLAY_PATH, realtime, &result);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Replayed %lu records (%lu skipped) in %lld us, %.0f records/s, hash %08lx",
+                 (unsigned long)result.records, (unsigned long)result.skipped,
+                 (long long)result.elapsed_us,
+                 result.elapsed_us ? result.records * 1e6 / result.elapsed_us : 0.0,
+                 (unsigned long)result.hash);
+    }
+
+#if CONFIG_CAPTURE_REPLAY_EXPECT_HASH
+    if (err != ESP_OK || result.hash != CONFIG_CAPTURE_REPLAY_EXPECT_HASH) {
+        ESP_LOGE(TAG, "REPLAY FAILED: hash %08lx, expected %08lx",
+                 err == ESP_OK ? (unsigned long)result.hash : 0UL,
+                 (unsigned long)CONFIG_CAPTURE_REPLAY_EXPECT_HASH);
+        exit(EXIT_FAILURE);
+    }
+    ESP_LOGI(TAG, "Replay matches expected hash");
+    exit(EXIT_SUCCESS);
+#endif
+    vTaskDelete(NULL);
+}
+
+void capture_replay_start(void)
+{
+    xTaskCreate(capture_replay_task, "capture_replay", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
+}
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Raw sample capture format:
+ *
+ *   header:  "SKCP" version:u8 reserved:u8[3]
+ *   record:  source:u8 len:u8 dt_us:u32 payload:u8[len]
+ *
+ * Payloads are the register bytes exactly as read from the bus, `dt_us` is
+ * the time since the previous record (saturating). All fields little endian.
+ * A source byte of 0xff ends the capture: that is what erased flash reads
+ * as, so a dump of the whole capture partition replays as-is.
+ */
+#define CAPTURE_MAGIC       "SKCP"
+#define CAPTURE_VERSION     1
+#define CAPTURE_PARTITION_SUBTYPE   0x40    /*!< Data partition subtype, see partitions.csv */
+
+typedef enum {
+    CAPTURE_SRC_TH_SENSOR = 1,      /*!< TH_SENSOR_RAW_LEN bytes of AHT20 measurement */
+    CAPTURE_SRC_ACCELEROMETER = 2,  /*!< ACCELEROMETER_RAW_LEN bytes of LIS3DH registers */
+    CAPTURE_SRC_END = 0xff,
+} capture_source_t;
+
+typedef struct {
+    bool active;            /*!< Accepting records */
+    bool writing;           /*!< Writer still draining records to the sink */
+    uint32_t records;       /*!< Records accepted since the last start */
+    uint32_t dropped;       /*!< Records lost because the writer fell behind */
+    uint32_t bytes;         /*!< Bytes written to the sink, header included */
+} capture_stats_t;
+
+/**
+ * @brief Start recording raw payloads.
+ *
+ * On the device records go to the CONFIG_CAPTURE_PARTITION data partition,
+ * erased a sector at a time just ahead of the data; read it back with
+ * `parttool.py read_partition`. On the Linux target they go to
+ * CONFIG_CAPTURE_PATH. A writer task drains records to the sink within
+ * CAPTURE_FLUSH_MS, so a reset loses at most that much. Recording stops on
+ * capture_stop(), after CONFIG_CAPTURE_DURATION_S or when the sink is full.
+ */
+esp_err_t capture_start(void);
+
+/**
+ * @brief Stop accepting records. Does not wait.
+ *
+ * The writer task writes out what was accepted and closes the sink in the
+ * background; capture_get_stats() reports `writing` until it has.
+ */
+void capture_stop(void);
+
+/**
+ * @brief Append a payload with its acquisition time. No-op unless capturing.
+ *
+ * Costs a copy into a stream buffer under a mutex; the sink is written by
+ * another task and a full buffer drops the record instead of waiting. On the
+ * device, flash writes and erases still suspend the cache, which stalls
+ * code running from flash, sensor loops included, for their duration.
+ */
+void capture_record(capture_source_t source, const uint8_t *payload, size_t len);
+
+void capture_get_stats(capture_stats_t *out);
+
+#if CONFIG_CAPTURE_REPLAY
+typedef struct {
+    uint32_t records;       /*!< Records fed through the conversion code */
+    uint32_t skipped;       /*!< Unknown sources or wrong payload lengths */
+    int64_t elapsed_us;
+    uint32_t hash;          /*!< FNV-1a over every published value, for bit-exact comparison */
+} capture_replay_result_t;
+
+/**
+ * @brief Feed a capture file through the same conversion and publishing code
+ *        as the live sensors.
+ *
+ * @param path     Capture file
+ * @param realtime Honor the recorded inter-sample delays, or run flat out
+ * @param out      Replay statistics
+ */
+esp_err_t capture_replay(const char *path, bool realtime, capture_replay_result_t *out);
+
+/**
+ * @brief Replay CONFIG_CAPTURE_REPLAY_PATH in a task and log the result.
+ *
+ * With CONFIG_CAPTURE_REPLAY_EXPECT_HASH set, the process exits after the
+ * replay with status 0 if the hash matched and 1 otherwise, so a build can
+ * be checked against a known capture.
+ */
+void capture_replay_start(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
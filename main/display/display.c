@@ -6,6 +6,7 @@
 // static const char *TAG = "display";
 
 u8g2_t u8g2; // a structure which will contain all the data for one display
+static bool needs_reinit = false;   // set by bus recovery, guarded by i2c_mutex
 
 static uint8_t u8x8_byte_esp32_i2c(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr) {
     static uint8_t buffer[32];
@@ -25,7 +26,7 @@ static uint8_t u8x8_byte_esp32_i2c(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, v
             buf_idx = 0;
             break;
         case U8X8_MSG_BYTE_END_TRANSFER:
-            i2c_master_transmit(i2c_dev_display, buffer, buf_idx, 1000 / portTICK_PERIOD_MS);
+            i2c_bus_transmit(I2C_DEV_DISPLAY, buffer, buf_idx);
             break;
         default:
             return 0;
@@ -45,7 +46,14 @@ static uint8_t u8x8_gpio_and_delay_esp32(u8x8_t *u8x8, uint8_t msg, uint8_t arg_
     return 1;
 }
 
+// Called by bus recovery, which for the display runs inside the byte callback
+// of an ongoing u8g2 transfer. Defer the controller setup to the next frame.
+static void u8g2_display_reinit(void) {
+    needs_reinit = true;
+}
+
 void u8g2_display_init(void) {
+    i2c_bus_set_reinit(I2C_DEV_DISPLAY, u8g2_display_reinit);
     u8g2_Setup_ssd1306_i2c_128x32_univision_f(&u8g2, U8G2_R0, u8x8_byte_esp32_i2c, u8x8_gpio_and_delay_esp32);
     u8g2_InitDisplay(&u8g2);
     vTaskDelay(pdMS_TO_TICKS(100));  // Add a 100ms delay
@@ -58,6 +66,13 @@ void u8g2_display_init(void) {
 
 void display_th_sensor_data(float temperature, float humidity) {
     char buf[16];
+    if (needs_reinit) {
+        // Controller setup only, the frame below repaints the screen
+        needs_reinit = false;
+        u8g2_InitDisplay(&u8g2);
+        u8g2_SetPowerSave(&u8g2, 0);
+    }
+
     u8g2_ClearBuffer(&u8g2);
     u8g2_SetFont(&u8g2, u8g2_font_8x13B_tr);
 
@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "dlog";
+
+#define DLOG_RING_SIZE      CONFIG_DLOG_RING_SIZE
+#define DLOG_RING_MASK      (DLOG_RING_SIZE - 1)
+#define DLOG_LINE_SIZE      192
+#define DLOG_DRAIN_PERIOD   pdMS_TO_TICKS(50)
+#define DLOG_RATE_SLOTS     8
+
+_Static_assert((DLOG_RING_SIZE & DLOG_RING_MASK) == 0, "DLOG_RING_SIZE must be a power of two");
+
+typedef union {
+    int32_t i;
+    uint32_t u;
+    float f;
+    const char *s;
+} dlog_value_t;
+
+typedef struct {
+    const char *format;     /*!< Doubles as the format ID: it points into rodata */
+    const char *tag;
+    uint32_t ticks;
+    uint8_t level;
+    uint8_t nargs;
+    uint8_t types;          /*!< 2 bits per argument, dlog_arg_type_t */
+    uint8_t reserved;
+    dlog_value_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+/*
+ * Bounded MPSC queue (Vyukov): each cell carries a sequence number telling
+ * producers and the consumer whose turn it is, so writers on the same core
+ * that preempt each other never need a lock. One ring per core keeps the
+ * cache lines of the two cores apart.
+ *
+ * Cells store their sequence minus their index, so the zero-initialized
+ * rings are ready before dlog_init() and early boot code can log too.
+ */
+typedef struct {
+    atomic_uint seq;
+    dlog_record_t rec;
+} dlog_cell_t;
+
+#if !CONFIG_IDF_TARGET_LINUX
+// The DLOG_RING_SIZE help text quotes this for RAM sizing
+_Static_assert(sizeof(dlog_cell_t) == 36, "update the DLOG_RING_SIZE help text");
+#endif
+
+typedef struct {
+    atomic_uint enqueue_pos;
+    uint32_t dequeue_pos;   /*!< Only touched by the drain task */
+    dlog_cell_t cells[DLOG_RING_SIZE];
+} dlog_ring_t;
+
+static dlog_ring_t rings[portNUM_PROCESSORS];
+static atomic_uint dropped = 0;
+
+/*
+ * Rate limit slots are claimed once and never released, so writers can scan
+ * them without a lock: `used` is published after the tag is in place.
+ */
+typedef struct {
+    atomic_bool used;
+    char tag[DLOG_TAG_MAX_LEN];
+    atomic_uint per_second;
+    atomic_uint window;     /*!< Second the count belongs to */
+    atomic_uint count;
+} dlog_rate_t;
+
+static dlog_rate_t rate_limits[DLOG_RATE_SLOTS];
+static portMUX_TYPE rate_lock = portMUX_INITIALIZER_UNLOCKED;   // setters only
+
+static inline unsigned cell_seq_load(dlog_cell_t *cell, unsigned pos)
+{
+    return atomic_load_explicit(&cell->seq, memory_order_acquire) + (pos & DLOG_RING_MASK);
+}
+
+static inline void cell_seq_store(dlog_cell_t *cell, unsigned pos, unsigned seq)
+{
+    atomic_store_explicit(&cell->seq, seq - (pos & DLOG_RING_MASK), memory_order_release);
+}
+
+static inline int dlog_core_id(void)
+{
+#if portNUM_PROCESSORS > 1
+    return xPortGetCoreID();
+#else
+    return 0;
+#endif
+}
+
+static bool dlog_rate_allows(const char *tag, uint32_t ticks)
+{
+    for (int i = 0; i < DLOG_RATE_SLOTS; i++) {
+        dlog_rate_t *r = &rate_limits[i];
+        if (!atomic_load_explicit(&r->used, memory_order_acquire)) {
+            return true;
+        }
+        if (strcmp(r->tag, tag) != 0) {
+            continue;
+        }
+        unsigned per_second = atomic_load_explicit(&r->per_second, memory_order_relaxed);
+        if (per_second == 0) {
+            return true;
+        }
+
+        unsigned now = pdTICKS_TO_MS(ticks) / 1000;
+        unsigned window = atomic_load_explicit(&r->window, memory_order_relaxed);
+        if (window != now &&
+            atomic_compare_exchange_strong(&r->window, &window, now)) {
+            atomic_store_explicit(&r->count, 0, memory_order_relaxed);
+        }
+        return atomic_fetch_add_explicit(&r->count, 1, memory_order_relaxed) < per_second;
+    }
+    return true;
+}
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *format,
+                const dlog_arg_t *args, uint32_t nargs)
+{
+    uint32_t ticks = xTaskGetTickCount();
+    if (!dlog_rate_allows(tag, ticks)) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    dlog_ring_t *ring = &rings[dlog_core_id()];
+    unsigned pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    dlog_cell_t *cell;
+    while (1) {
+        cell = &ring->cells[pos & DLOG_RING_MASK];
+        int diff = (int)(cell_seq_load(cell, pos) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    dlog_record_t *rec = &cell->rec;
+    rec->format = format;
+    rec->tag = tag;
+    rec->ticks = ticks;
+    rec->level = level;
+    rec->nargs = nargs;
+    rec->types = 0;
+    for (uint32_t i = 0; i < nargs; i++) {
+        rec->types |= args[i].type << (2 * i);
+        rec->args[i].u = 0;
+        switch (args[i].type) {
+            case DLOG_ARG_STR:   rec->args[i].s = args[i].s; break;
+            case DLOG_ARG_FLOAT: rec->args[i].f = args[i].f; break;
+            default:             rec->args[i].u = args[i].u; break;
+        }
+    }
+    cell_seq_store(cell, pos, pos + 1);
+}
+
+#if !CONFIG_DLOG_OUTPUT_BINARY
+/**
+ * @brief printf the stored arguments back into the format string.
+ *
+ * Each conversion is handed to snprintf on its own with the length modifier
+ * stripped, since arguments were widened/narrowed to 32 bits when stored.
+ */
+static void dlog_format(char *out, size_t size, const dlog_record_t *rec)
+{
+    const char *p = rec->format;
+    size_t len = 0;
+    uint32_t arg = 0;
+
+    while (*p && len + 1 < size) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        char spec[16];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && n < sizeof(spec) - 2) {
+            spec[n++] = *p++;
+        }
+        while (*p && strchr("hlLqjzt", *p)) {
+            p++;
+        }
+        char conv = *p ? *p++ : 's';
+        spec[n++] = conv;
+        spec[n] = '\0';
+
+        int w;
+        if (arg >= rec->nargs) {
+            w = snprintf(out + len, size - len, "?");
+        } else {
+            dlog_value_t v = rec->args[arg];
+            switch ((rec->types >> (2 * arg)) & 0x3) {
+                case DLOG_ARG_FLOAT:
+                    w = strchr("fFeEgGaA", conv) ? snprintf(out + len, size - len, spec, (double)v.f)
+                                                 : snprintf(out + len, size - len, "?");
+                    break;
+                case DLOG_ARG_STR:
+                    w = conv == 's' ? snprintf(out + len, size - len, spec, v.s)
+                                    : snprintf(out + len, size - len, "?");
+                    break;
+                case DLOG_ARG_UINT:
+                    w = snprintf(out + len, size - len, spec, (unsigned)v.u);
+                    break;
+                default:
+                    w = snprintf(out + len, size - len, spec, (int)v.i);
+                    break;
+            }
+            arg++;
+        }
+        len += w < 0 ? 0 : w;
+        if (len >= size) {
+            len = size - 1;
+        }
+    }
+    out[len] = '\0';
+}
+
+static const char level_chars[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+
+static void dlog_emit(const dlog_record_t *rec)
+{
+    char line[DLOG_LINE_SIZE];
+    dlog_format(line, sizeof(line), rec);
+    printf("%c (%lu) %s: %s\n", level_chars[rec->level < sizeof(level_chars) ? rec->level : 0],
+           (unsigned long)pdTICKS_TO_MS(rec->ticks), rec->tag, line);
+}
+#else
+static char *put_hex(char *p, const void *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    const uint8_t *b = data;
+    while (len--) {
+        *p++ = digits[*b >> 4];
+        *p++ = digits[*b++ & 0xf];
+    }
+    return p;
+}
+
+/**
+ * @brief Ship the unformatted record; tools/dlog_decode.py renders it.
+ *
+ * Records go out as one text line, "#dl:" followed by hex, so they interleave
+ * safely with ESP_LOGx output on the same console and survive idf.py monitor.
+ * Payload, little-endian: format address, tag address, uptime ms (u32 each),
+ * level, nargs, types (u8 each), then one u32 per argument. Format, tag and
+ * string arguments are rodata addresses the decoder resolves from the ELF.
+ */
+static void dlog_emit(const dlog_record_t *rec)
+{
+    char line[4 + 2 * (15 + 4 * DLOG_MAX_ARGS) + 2];
+    char *p = line;
+    uint32_t words[3] = { (uint32_t)(uintptr_t)rec->format, (uint32_t)(uintptr_t)rec->tag,
+                          pdTICKS_TO_MS(rec->ticks) };
+    uint8_t meta[3] = { rec->level, rec->nargs, rec->types };
+
+    memcpy(p, "#dl:", 4);
+    p = put_hex(p + 4, words, sizeof(words));
+    p = put_hex(p, meta, sizeof(meta));
+    for (int i = 0; i < rec->nargs; i++) {
+        uint32_t v = ((rec->types >> (2 * i)) & 0x3) == DLOG_ARG_STR ? (uint32_t)(uintptr_t)rec->args[i].s
+                                                                     : rec->args[i].u;
+        p = put_hex(p, &v, sizeof(v));
+    }
+    *p++ = '\n';
+    fwrite(line, 1, p - line, stdout);
+}
+#endif
+
+static bool dlog_drain_ring(dlog_ring_t *ring)
+{
+    unsigned pos = ring->dequeue_pos;
+    dlog_cell_t *cell = &ring->cells[pos & DLOG_RING_MASK];
+    if ((int)(cell_seq_load(cell, pos) - (pos + 1)) < 0) {
+        return false;
+    }
+
+    dlog_record_t rec = cell->rec;
+    cell_seq_store(cell, pos, pos + DLOG_RING_SIZE);
+    ring->dequeue_pos++;
+    dlog_emit(&rec);
+    return true;
+}
+
+static void dlog_drain_task(void *pvParameters)
+{
+    uint32_t reported_drops = 0;
+
+    while (1) {
+        bool any;
+        do {
+            any = false;
+            for (int core = 0; core < portNUM_PROCESSORS; core++) {
+                any |= dlog_drain_ring(&rings[core]);
+            }
+        } while (any);
+
+        uint32_t drops = atomic_load_explicit(&dropped, memory_order_relaxed);
+        if (drops != reported_drops) {
+            ESP_LOGW(TAG, "%lu records dropped", (unsigned long)(drops - reported_drops));
+            reported_drops = drops;
+        }
+        fflush(stdout);
+        vTaskDelay(DLOG_DRAIN_PERIOD);
+    }
+}
+
+void dlog_init(void)
+{
+    static atomic_flag started = ATOMIC_FLAG_INIT;
+    if (atomic_flag_test_and_set(&started)) {
+        return;
+    }
+
+    xTaskCreate(dlog_drain_task, "dlog_drain", 3072, NULL,
+                CONFIG_DLOG_DRAIN_PRIORITY, NULL);
+}
+
+esp_err_t dlog_set_rate_limit(const char *tag, uint32_t per_second)
+{
+    size_t len = strlen(tag);
+    if (len == 0 || len >= DLOG_TAG_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_ERR_NO_MEM;
+    taskENTER_CRITICAL(&rate_lock);
+    for (int i = 0; i < DLOG_RATE_SLOTS; i++) {
+        dlog_rate_t *r = &rate_limits[i];
+        bool used = atomic_load_explicit(&r->used, memory_order_relaxed);
+        if (used && strcmp(r->tag, tag) != 0) {
+            continue;
+        }
+        atomic_store_explicit(&r->per_second, per_second, memory_order_relaxed);
+        if (!used) {
+            memcpy(r->tag, tag, len + 1);
+            atomic_store_explicit(&r->used, true, memory_order_release);
+        }
+        err = ESP_OK;
+        break;
+    }
+    taskEXIT_CRITICAL(&rate_lock);
+    return err;
+}
+
+size_t dlog_get_rate_limits(dlog_rate_limit_t *out, size_t max)
+{
+    size_t n = 0;
+    for (int i = 0; i < DLOG_RATE_SLOTS && n < max; i++) {
+        dlog_rate_t *r = &rate_limits[i];
+        if (!atomic_load_explicit(&r->used, memory_order_acquire)) {
+            break;
+        }
+        strcpy(out[n].tag, r->tag);
+        out[n].per_second = atomic_load_explicit(&r->per_second, memory_order_relaxed);
+        n++;
+    }
+    return n;
+}
+
+uint32_t dlog_dropped(void)
+{
+    return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
+
+#if CONFIG_DLOG_BENCHMARK
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_cpu.h"
+#define bench_now() esp_cpu_get_cycle_count()
+#define BENCH_UNIT  "cycles"
+#else
+#define bench_now() ((uint32_t)(esp_timer_get_time() * 1000))
+#define BENCH_UNIT  "ns"
+#endif
+
+// Less than the smallest ring, so no DLOGI call takes the drop path
+#define BENCH_CALLS 32
+
+void dlog_benchmark(void)
+{
+    float x = 0.12f, y = -0.98f, z = 1.01f;
+
+    uint32_t start = bench_now();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        DLOGI(TAG, "X: %.2f g, Y: %.2f g, Z: %.2f g", x, y, z);
+    }
+    uint32_t dlog_cost = (bench_now() - start) / BENCH_CALLS;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        ESP_LOGI(TAG, "X: %.2f g, Y: %.2f g, Z: %.2f g", x, y, z);
+    }
+    uint32_t esp_log_cost = (bench_now() - start) / BENCH_CALLS;
+
+    ESP_LOGI(TAG, "Per call: DLOGI %lu %s, ESP_LOGI %lu %s",
+             (unsigned long)dlog_cost, BENCH_UNIT, (unsigned long)esp_log_cost, BENCH_UNIT);
+}
+#endif
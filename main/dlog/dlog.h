@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deferred logging.
+ *
+ * DLOGx() stores the format string pointer and raw argument words in a
+ * per-core ring; a low-priority task does the formatting and output later.
+ * A call costs a few dozen cycles instead of a full vprintf + UART write,
+ * which keeps float formatting out of the sampling loops.
+ *
+ * Restrictions compared to ESP_LOGx:
+ *  - at most DLOG_MAX_ARGS arguments of integer, float/double or string type;
+ *    integers wider than 32 bits are rejected at compile time, except
+ *    `long` and `unsigned long`, which are truncated to 32 bits so the usual
+ *    `(unsigned long)` casts for %lu also build on the 64-bit Linux target
+ *    (where int64_t is a `long` too and is truncated the same way)
+ *  - string arguments are stored by pointer, so they must outlive the
+ *    record: literals and other static strings only
+ *  - floats are stored in single precision
+ */
+
+#define DLOG_MAX_ARGS 4
+#define DLOG_TAG_MAX_LEN 16     /*!< Including the terminating NUL, for rate limits */
+
+typedef enum {
+    DLOG_ARG_INT,
+    DLOG_ARG_UINT,
+    DLOG_ARG_FLOAT,
+    DLOG_ARG_STR,
+} dlog_arg_type_t;
+
+typedef struct {
+    uint32_t type;
+    union {
+        int32_t i;
+        uint32_t u;
+        float f;
+        const char *s;
+    };
+} dlog_arg_t;
+
+static inline dlog_arg_t dlog_arg_int(int32_t v)       { return (dlog_arg_t){ .type = DLOG_ARG_INT, .i = v }; }
+static inline dlog_arg_t dlog_arg_uint(uint32_t v)     { return (dlog_arg_t){ .type = DLOG_ARG_UINT, .u = v }; }
+static inline dlog_arg_t dlog_arg_long(long v)         { return (dlog_arg_t){ .type = DLOG_ARG_INT, .i = (int32_t)v }; }
+static inline dlog_arg_t dlog_arg_ulong(unsigned long v) { return (dlog_arg_t){ .type = DLOG_ARG_UINT, .u = (uint32_t)v }; }
+static inline dlog_arg_t dlog_arg_float(double v)      { return (dlog_arg_t){ .type = DLOG_ARG_FLOAT, .f = (float)v }; }
+static inline dlog_arg_t dlog_arg_str(const char *v)   { return (dlog_arg_t){ .type = DLOG_ARG_STR, .s = v }; }
+
+// Arguments are stored in 32 bits; only long is truncated on purpose, see above
+#define DLOG_ARG_FITS(x) (sizeof(x) <= sizeof(uint32_t) || _Generic((x), \
+    double: 1, char *: 1, const char *: 1, long: 1, unsigned long: 1, default: 0))
+
+#define DLOG_ARG(x) ((void)sizeof(struct {                                      \
+        _Static_assert(DLOG_ARG_FITS(x), "DLOG: 64-bit integer argument, cast it"); \
+        int dlog_unused; }),                                                    \
+    DLOG_ARG_TYPED(x))
+
+#define DLOG_ARG_TYPED(x) _Generic((x),             \
+    float: dlog_arg_float,                          \
+    double: dlog_arg_float,                         \
+    char *: dlog_arg_str,                           \
+    const char *: dlog_arg_str,                     \
+    unsigned char: dlog_arg_uint,                   \
+    unsigned short: dlog_arg_uint,                  \
+    unsigned int: dlog_arg_uint,                    \
+    long: dlog_arg_long,                            \
+    unsigned long: dlog_arg_ulong,                  \
+    default: dlog_arg_int)(x)
+
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, N, ...) N
+
+#define DLOG_ARGS_0()
+#define DLOG_ARGS_1(a)          DLOG_ARG(a)
+#define DLOG_ARGS_2(a, b)       DLOG_ARG(a), DLOG_ARG(b)
+#define DLOG_ARGS_3(a, b, c)    DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c)
+#define DLOG_ARGS_4(a, b, c, d) DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d)
+#define DLOG_ARGS_N(n, ...)     DLOG_ARGS_##n(__VA_ARGS__)
+#define DLOG_ARGS(n, ...)       DLOG_ARGS_N(n, ##__VA_ARGS__)
+
+// Levels are filtered at compile time like ESP_LOGx; use dlog_set_rate_limit() at runtime
+#define DLOG_LEVEL(level, tag, format, ...) do {                                \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                       \
+            dlog_write(level, tag, format,                                      \
+                       (const dlog_arg_t[DLOG_MAX_ARGS]){                       \
+                           DLOG_ARGS(DLOG_NARGS(__VA_ARGS__), ##__VA_ARGS__) }, \
+                       DLOG_NARGS(__VA_ARGS__));                                \
+        }                                                                       \
+    } while (0)
+
+#define DLOGE(tag, format, ...) DLOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define DLOGW(tag, format, ...) DLOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define DLOGI(tag, format, ...) DLOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define DLOGD(tag, format, ...) DLOG_LEVEL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+
+/**
+ * @brief Queue a log record. Use the DLOGx() macros instead of calling this.
+ *
+ * Never blocks; when the ring is full or the tag is over its rate limit the
+ * record is dropped and counted.
+ */
+void dlog_write(esp_log_level_t level, const char *tag, const char *format,
+                const dlog_arg_t *args, uint32_t nargs);
+
+/**
+ * @brief Start the drain task. Records written before this are kept.
+ */
+void dlog_init(void);
+
+typedef struct {
+    char tag[DLOG_TAG_MAX_LEN];
+    uint32_t per_second;    /*!< 0 when the limit was removed */
+} dlog_rate_limit_t;
+
+/**
+ * @brief Limit a tag to `per_second` records per second, 0 to remove the limit.
+ *
+ * The tag is copied, so it may come from a request buffer. Slots are never
+ * freed; removing a limit keeps the tag's slot for later.
+ *
+ * @return ESP_ERR_INVALID_ARG if the tag is empty or too long,
+ *         ESP_ERR_NO_MEM if all rate limit slots are in use
+ */
+esp_err_t dlog_set_rate_limit(const char *tag, uint32_t per_second);
+
+/**
+ * @brief Copy up to `max` configured rate limits.
+ * @return Number of entries written
+ */
+size_t dlog_get_rate_limits(dlog_rate_limit_t *out, size_t max);
+
+/**
+ * @brief Records dropped because a ring was full or a tag over its limit.
+ */
+uint32_t dlog_dropped(void);
+
+#if CONFIG_DLOG_BENCHMARK
+/**
+ * @brief Compare the cost of DLOGI() and ESP_LOGI() with the same arguments.
+ */
+void dlog_benchmark(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
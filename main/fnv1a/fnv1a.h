@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 32-bit FNV-1a. Cheap and good enough for ETags, hash table slots and
+ * replay checksums; not for anything adversarial.
+ */
+#define FNV1A32_INIT    2166136261u
+
+/**
+ * @brief Fold `len` bytes into `hash`. Start from FNV1A32_INIT.
+ */
+static inline uint32_t fnv1a32(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Fold a NUL-terminated string into `hash`.
+ */
+static inline uint32_t fnv1a32_str(uint32_t hash, const char *s)
+{
+    while (*s) {
+        hash ^= (uint8_t)*s++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#ifdef __cplusplus
+}
+#endif
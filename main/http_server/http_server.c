@@ -1,11 +1,117 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "http_server.h"
 #include "th_sensor.h"
+#include "node_table.h"
+#include "boot_metrics.h"
+#include "i2c_bus.h"
+#include "dlog.h"
+#include "fnv1a.h"
+#include "capture.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
 
 #define TH_BUF_SIZE 256
+#define NODES_BUF_SIZE 384
+#define RESP_CACHE_BODY_SIZE 128
+#define RESP_CACHE_MAX_AGE "max-age=1"
+#define IF_NONE_MATCH_SIZE 128
 
 static const char *TAG = "http_server";
 
+/*
+ * Pre-rendered response cache.
+ *
+ * Each cached resource keeps its serialized body and a strong ETag derived
+ * from the body contents. The body is only re-rendered when the publisher's
+ * sequence number moves, so repeated polls cost a memcpy into the socket, or
+ * an empty 304 when the client already holds the current representation.
+ *
+ * All URI handlers run in the single httpd task, so the cache needs no lock.
+ */
+typedef struct {
+    const char *type;
+    uint32_t (*seq)(void);                      /*!< NULL for static content */
+    int (*render)(char *buf, size_t size);
+    bool valid;
+    uint32_t last_seq;
+    size_t len;
+    char etag[12];                              /*!< "%08lx" with quotes */
+    char body[RESP_CACHE_BODY_SIZE];
+} resp_cache_t;
+
+static void resp_cache_refresh(resp_cache_t *cache)
+{
+    uint32_t seq = cache->seq ? cache->seq() : 0;
+    if (cache->valid && seq == cache->last_seq) {
+        return;
+    }
+
+    int len = cache->render(cache->body, sizeof(cache->body));
+    if (len < 0 || len >= (int)sizeof(cache->body)) {
+        ESP_LOGE(TAG, "Cached body truncated (%d bytes)", len);
+        len = len < 0 ? 0 : sizeof(cache->body) - 1;
+    }
+    cache->len = len;
+    snprintf(cache->etag, sizeof(cache->etag), "\"%08lx\"",
+             (unsigned long)fnv1a32(FNV1A32_INIT, cache->body, cache->len));
+    cache->last_seq = seq;
+    cache->valid = true;
+}
+
+static bool etag_token_end(char c)
+{
+    return c == '\0' || c == ',' || c == ' ' || c == '\t';
+}
+
+/**
+ * @brief Check an If-None-Match header value against our ETag.
+ *
+ * Handles `*`, comma separated lists and weak validators (W/"..."), which
+ * If-None-Match compares like strong ones. A list entry must equal the
+ * ETag exactly, not just start with it.
+ */
+static bool etag_matches(const char *header, const char *etag)
+{
+    size_t etag_len = strlen(etag);
+    const char *p = header;
+
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (p[0] == '*' && etag_token_end(p[1])) return true;
+        if (p[0] == 'W' && p[1] == '/') p += 2;
+        if (strncmp(p, etag, etag_len) == 0 && etag_token_end(p[etag_len])) return true;
+        while (*p && *p != ',') p++;
+    }
+    return false;
+}
+
+static esp_err_t resp_cache_send(httpd_req_t *req, resp_cache_t *cache)
+{
+    resp_cache_refresh(cache);
+
+    httpd_resp_set_hdr(req, "ETag", cache->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", RESP_CACHE_MAX_AGE);
+
+    char inm[IF_NONE_MATCH_SIZE];
+    size_t inm_len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+    if (inm_len > 0 && inm_len < sizeof(inm) &&
+        httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) == ESP_OK &&
+        etag_matches(inm, cache->etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    httpd_resp_set_type(req, cache->type);
+    return httpd_resp_send(req, cache->body, cache->len);
+}
+
 // favicon
 static esp_err_t favicon_get_handler(httpd_req_t *req)
 {
@@ -20,10 +126,19 @@ static const httpd_uri_t favicon_uri = {
 };
 
 // hello
+static int hello_render(char *buf, size_t size)
+{
+    return snprintf(buf, size, "Hello ESP32");
+}
+
+static resp_cache_t hello_cache = {
+    .type = HTTPD_TYPE_TEXT,
+    .render = hello_render,
+};
+
 static esp_err_t hello_get_handler(httpd_req_t *req)
 {
-    httpd_resp_send(req, "Hello ESP32", HTTPD_RESP_USE_STRLEN);
-    return ESP_OK;
+    return resp_cache_send(req, &hello_cache);
 }
 
 static const httpd_uri_t hello = {
@@ -33,13 +148,29 @@ static const httpd_uri_t hello = {
 };
 
 // th_sensor
+static uint32_t th_sensor_seq(void)
+{
+    return th_sensor_get_reading(NULL, NULL, NULL);
+}
+
+static int th_sensor_render(char *buf, size_t size)
+{
+    float temp, hum;
+    bool stale;
+    th_sensor_get_reading(&temp, &hum, &stale);
+    return snprintf(buf, size, "{\"temperature\":%.1f,\"humidity\":%.1f,\"stale\":%s}",
+                    temp, hum, stale ? "true" : "false");
+}
+
+static resp_cache_t th_sensor_cache = {
+    .type = HTTPD_TYPE_JSON,
+    .seq = th_sensor_seq,
+    .render = th_sensor_render,
+};
+
 static esp_err_t th_sensor_get_handler(httpd_req_t *req)
 {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "{\"temperature\":%.1f,\"humidity\":%.1f}", temperature, humidity);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, buf, HTTPD_RESP_USE_STRLEN);
-    return ESP_OK;
+    return resp_cache_send(req, &th_sensor_cache);
 }
 
 static const httpd_uri_t th_sensor_get = {
@@ -48,13 +179,83 @@ static const httpd_uri_t th_sensor_get = {
     .handler  = th_sensor_get_handler,
 };
 
+/**
+ * @brief Use the peer address as node id for senders that don't name themselves.
+ */
+static void get_peer_id(httpd_req_t *req, char *id, size_t size)
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    int fd = httpd_req_to_sockfd(req);
+
+    snprintf(id, size, "unknown");
+    if (getpeername(fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        return;
+    }
+    if (addr.ss_family == AF_INET) {
+        inet_ntop(AF_INET, &((struct sockaddr_in *)&addr)->sin_addr, id, size);
+    } else if (addr.ss_family == AF_INET6) {
+        const uint8_t *a6 = ((struct sockaddr_in6 *)&addr)->sin6_addr.s6_addr;
+        static const uint8_t v4mapped[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+        // IPv4 peers on a dual-stack socket show up as ::ffff:a.b.c.d
+        if (memcmp(a6, v4mapped, sizeof(v4mapped)) == 0) {
+            inet_ntop(AF_INET, &a6[12], id, size);
+        } else {
+            inet_ntop(AF_INET6, a6, id, size);
+        }
+    }
+}
+
+/**
+ * @brief Ingest a reading POSTed by a peer node.
+ *
+ * The body is received straight into a fixed stack buffer, parsed in place
+ * and stored in the node table. Oversized bodies are rejected up front so we
+ * never read more than the buffer can hold.
+ */
 static esp_err_t th_sensor_post_handler(httpd_req_t *req)
 {
     char buf[TH_BUF_SIZE];
-    int ret = httpd_req_recv(req, buf, TH_BUF_SIZE);
-    if (ret > 0) {
-        buf[ret] = '\0';
-        ESP_LOGI(TAG, "Received: %s", buf);
+    size_t remaining = req->content_len;
+
+    if (remaining == 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Empty body");
+        return ESP_OK;
+    }
+    if (remaining >= sizeof(buf)) {
+        httpd_resp_set_status(req, "413 Payload Too Large");
+        httpd_resp_send(req, "Body too large", HTTPD_RESP_USE_STRLEN);
+        return ESP_OK;
+    }
+
+    size_t received = 0;
+    while (remaining > 0) {
+        int ret = httpd_req_recv(req, buf + received, remaining);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret <= 0) {
+            // Socket is closed by the server when returning ESP_FAIL
+            return ESP_FAIL;
+        }
+        received += ret;
+        remaining -= ret;
+    }
+    buf[received] = '\0';
+
+    char peer[NODE_ID_MAX_LEN];
+    get_peer_id(req, peer, sizeof(peer));
+
+    esp_err_t err = node_table_ingest_json(buf, peer);
+    if (err == ESP_ERR_NO_MEM) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_send(req, "Node table full", HTTPD_RESP_USE_STRLEN);
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rejected reading from %s", peer);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid reading");
+        return ESP_OK;
     }
 
     httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
@@ -67,14 +268,329 @@ static const httpd_uri_t th_sensor_post = {
     .handler  = th_sensor_post_handler,
 };
 
+// nodes
+/**
+ * @brief Serve the gateway's node table as a JSON array.
+ *
+ * Each node is snapshotted and streamed as its own chunk, so the response
+ * size is independent of the table capacity.
+ */
+static esp_err_t nodes_get_handler(httpd_req_t *req)
+{
+    char buf[NODES_BUF_SIZE];
+    node_entry_t node;
+    bool first = true;
+    uint32_t now_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_sendstr_chunk(req, "[");
+
+    for (size_t slot = 0; slot < NODE_TABLE_CAPACITY; slot++) {
+        if (!node_table_get(slot, &node)) {
+            continue;
+        }
+
+        const node_sample_t *latest = &node.history[node.head];
+        int len = snprintf(buf, sizeof(buf),
+                           "%s{\"node\":\"%s\",\"count\":%lu,\"age_ms\":%lu,"
+                           "\"timestamp\":%lu,\"temperature\":%.1f,\"humidity\":%.1f,\"history\":[",
+                           first ? "" : ",", node.id, (unsigned long)node.count,
+                           (unsigned long)(now_ms - latest->received_ms),
+                           (unsigned long)latest->timestamp, latest->temperature, latest->humidity);
+
+        // History is listed newest first
+        uint32_t kept = node.count < NODE_TABLE_HISTORY ? node.count : NODE_TABLE_HISTORY;
+        for (uint32_t i = 0; i < kept && len < (int)sizeof(buf); i++) {
+            const node_sample_t *s = &node.history[(node.head + NODE_TABLE_HISTORY - i) % NODE_TABLE_HISTORY];
+            len += snprintf(buf + len, sizeof(buf) - len, "%s[%.1f,%.1f]",
+                            i ? "," : "", s->temperature, s->humidity);
+        }
+        if (len < (int)sizeof(buf)) {
+            len += snprintf(buf + len, sizeof(buf) - len, "]}");
+        }
+        if (len >= (int)sizeof(buf)) {
+            ESP_LOGE(TAG, "Node entry truncated for %s", node.id);
+            len = sizeof(buf) - 1;
+        }
+
+        if (httpd_resp_send_chunk(req, buf, len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        first = false;
+    }
+
+    httpd_resp_sendstr_chunk(req, "]");
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static const httpd_uri_t nodes_get = {
+    .uri      = "/nodes",
+    .method   = HTTP_GET,
+    .handler  = nodes_get_handler,
+};
+
+// stats
+/*
+ * Session counters for load testing. open/close callbacks and URI handlers
+ * all run in the httpd task, so plain integers are enough.
+ *
+ * A close while every session slot is taken is counted as a purge: that is
+ * what LRU purging looks like from here, though a client hanging up at the
+ * same moment is counted too.
+ */
+static uint32_t sessions_opened = 0;
+static uint32_t sessions_closed = 0;
+static uint32_t sessions_purged = 0;
+
+static esp_err_t session_open(httpd_handle_t hd, int sockfd)
+{
+    sessions_opened++;
+    return ESP_OK;
+}
+
+static void session_close(httpd_handle_t hd, int sockfd)
+{
+    if (sessions_opened - sessions_closed >= CONFIG_WEB_SERVER_MAX_OPEN_SOCKETS) {
+        sessions_purged++;
+    }
+    sessions_closed++;
+    close(sockfd);
+}
+
+static esp_err_t stats_get_handler(httpd_req_t *req)
+{
+    char buf[384];
+    snprintf(buf, sizeof(buf),
+             "{\"opened\":%lu,\"closed\":%lu,\"purged\":%lu,\"max_open_sockets\":%d,"
+             "\"first_sample_ms\":%ld,\"got_ip_ms\":%ld,\"i2c\":{",
+             (unsigned long)sessions_opened, (unsigned long)sessions_closed,
+             (unsigned long)sessions_purged, CONFIG_WEB_SERVER_MAX_OPEN_SOCKETS,
+             (long)boot_metrics_first_sample_ms(), (long)boot_metrics_got_ip_ms());
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_sendstr_chunk(req, buf);
+
+    for (int dev = 0; dev < I2C_DEV_COUNT; dev++) {
+        i2c_dev_stats_t st;
+        i2c_bus_get_stats(dev, &st);
+        snprintf(buf, sizeof(buf),
+                 "%s\"%s\":{\"transfers\":%lu,\"errors\":%lu,\"recoveries\":%lu,"
+                 "\"failed_recoveries\":%lu,\"last_recovery_ms\":%ld,"
+                 "\"last_recovery_us\":%lu,\"max_recovery_us\":%lu,"
+                 "\"scl_speed_hz\":%lu,\"speed_fallbacks\":%lu,\"speed_restores\":%lu}",
+                 dev ? "," : "", i2c_bus_dev_name(dev),
+                 (unsigned long)st.transfers, (unsigned long)st.errors,
+                 (unsigned long)st.recoveries, (unsigned long)st.failed_recoveries,
+                 st.recoveries + st.failed_recoveries ? (long)(st.last_recovery_us / 1000) : -1L,
+                 (unsigned long)st.last_recovery_duration_us,
+                 (unsigned long)st.max_recovery_duration_us,
+                 (unsigned long)st.scl_speed_hz, (unsigned long)st.speed_fallbacks,
+                 (unsigned long)st.speed_restores);
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+
+    httpd_resp_sendstr_chunk(req, "}}");
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static const httpd_uri_t stats_get = {
+    .uri      = "/stats",
+    .method   = HTTP_GET,
+    .handler  = stats_get_handler,
+};
+
+// dlog
+static esp_err_t dlog_get_handler(httpd_req_t *req)
+{
+    dlog_rate_limit_t limits[8];
+    size_t n = dlog_get_rate_limits(limits, sizeof(limits) / sizeof(limits[0]));
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "{\"dropped\":%lu,\"rate_limits\":{",
+             (unsigned long)dlog_dropped());
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_sendstr_chunk(req, buf);
+
+    for (size_t i = 0; i < n; i++) {
+        snprintf(buf, sizeof(buf), "%s\"%s\":%lu", i ? "," : "",
+                 limits[i].tag, (unsigned long)limits[i].per_second);
+        httpd_resp_sendstr_chunk(req, buf);
+    }
+
+    httpd_resp_sendstr_chunk(req, "}}");
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static const httpd_uri_t dlog_get = {
+    .uri      = "/dlog",
+    .method   = HTTP_GET,
+    .handler  = dlog_get_handler,
+};
+
+/**
+ * @brief Set a deferred log rate limit: POST /dlog?tag=accelerometer&per_second=5
+ *
+ * per_second=0 removes the limit.
+ */
+static esp_err_t dlog_post_handler(httpd_req_t *req)
+{
+    char query[64], tag[DLOG_TAG_MAX_LEN], rate_str[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "tag", tag, sizeof(tag)) != ESP_OK ||
+        httpd_query_key_value(query, "per_second", rate_str, sizeof(rate_str)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "tag and per_second are required");
+        return ESP_OK;
+    }
+    for (const char *c = tag; *c; c++) {
+        // Tags are echoed into the GET /dlog JSON unescaped
+        if (*c < 0x20 || *c == '"' || *c == '\\') {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid tag");
+            return ESP_OK;
+        }
+    }
+    uint32_t per_second = strtoul(rate_str, NULL, 10);
+
+    esp_err_t err = dlog_set_rate_limit(tag, per_second);
+    if (err == ESP_ERR_NO_MEM) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No free rate limit slot");
+        return ESP_OK;
+    } else if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid tag");
+        return ESP_OK;
+    }
+    ESP_LOGI(TAG, "dlog rate limit for %s: %lu/s", tag, (unsigned long)per_second);
+    return httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
+}
+
+static const httpd_uri_t dlog_post = {
+    .uri      = "/dlog",
+    .method   = HTTP_POST,
+    .handler  = dlog_post_handler,
+};
+
+#if CONFIG_I2C_BUS_FAULT_INJECTION
+// i2c_fault
+/**
+ * @brief Fail the next transfers to a device: POST /i2c_fault?dev=th_sensor&count=5
+ */
+static esp_err_t i2c_fault_post_handler(httpd_req_t *req)
+{
+    char query[64], name[16], count_str[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "dev", name, sizeof(name)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "dev is required");
+        return ESP_OK;
+    }
+    uint32_t count = 1;
+    if (httpd_query_key_value(query, "count", count_str, sizeof(count_str)) == ESP_OK) {
+        count = strtoul(count_str, NULL, 10);
+    }
+
+    if (!i2c_mutex) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "I2C bus not initialized");
+        return ESP_OK;
+    }
+
+    for (int dev = 0; dev < I2C_DEV_COUNT; dev++) {
+        if (strcmp(name, i2c_bus_dev_name(dev)) == 0) {
+            xSemaphoreTake(i2c_mutex, portMAX_DELAY);
+            i2c_bus_inject_fault(dev, count, ESP_ERR_TIMEOUT);
+            xSemaphoreGive(i2c_mutex);
+            ESP_LOGW(TAG, "Injecting %lu faults into %s", (unsigned long)count, name);
+            return httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
+        }
+    }
+
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown device");
+    return ESP_OK;
+}
+
+static const httpd_uri_t i2c_fault_post = {
+    .uri      = "/i2c_fault",
+    .method   = HTTP_POST,
+    .handler  = i2c_fault_post_handler,
+};
+#endif
+
+#if CONFIG_CAPTURE_ENABLE
+// capture
+static esp_err_t capture_get_handler(httpd_req_t *req)
+{
+    capture_stats_t st;
+    capture_get_stats(&st);
+
+    char buf[144];
+    snprintf(buf, sizeof(buf),
+             "{\"active\":%s,\"writing\":%s,\"records\":%lu,\"dropped\":%lu,\"bytes\":%lu}",
+             st.active ? "true" : "false", st.writing ? "true" : "false",
+             (unsigned long)st.records, (unsigned long)st.dropped, (unsigned long)st.bytes);
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    return httpd_resp_sendstr(req, buf);
+}
+
+static const httpd_uri_t capture_get = {
+    .uri      = "/capture",
+    .method   = HTTP_GET,
+    .handler  = capture_get_handler,
+};
+
+/**
+ * @brief Start or stop sample capture: POST /capture?action=stop
+ *
+ * Stopping answers 202 right away; the writer task finishes in the
+ * background and GET /capture shows `writing` until the sink is closed.
+ */
+static esp_err_t capture_post_handler(httpd_req_t *req)
+{
+    char query[32], action[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "action", action, sizeof(action)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "action is required");
+        return ESP_OK;
+    }
+
+    if (strcmp(action, "stop") == 0) {
+        capture_stop();
+        httpd_resp_set_status(req, "202 Accepted");
+    } else if (strcmp(action, "start") == 0) {
+        esp_err_t err = capture_start();
+        if (err != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(err));
+            return ESP_OK;
+        }
+    } else {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "action is start or stop");
+        return ESP_OK;
+    }
+    return capture_get_handler(req);
+}
+
+static const httpd_uri_t capture_post = {
+    .uri      = "/capture",
+    .method   = HTTP_POST,
+    .handler  = capture_post_handler,
+};
+#endif
+
 // Server
 httpd_handle_t start_webserver(void)
 {
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.server_port = 8000;
+    config.server_port = CONFIG_WEB_SERVER_PORT;
+    config.max_open_sockets = CONFIG_WEB_SERVER_MAX_OPEN_SOCKETS;
+    config.stack_size = CONFIG_WEB_SERVER_STACK_SIZE;
+    config.task_priority = CONFIG_WEB_SERVER_TASK_PRIORITY;
+    config.core_id = CONFIG_WEB_SERVER_CORE_ID < 0 ? tskNO_AFFINITY : CONFIG_WEB_SERVER_CORE_ID;
+    config.open_fn = session_open;
+    config.close_fn = session_close;
 
     config.lru_purge_enable = true;
+    // Default is 8; leave room for the optional debug endpoints
+    config.max_uri_handlers = 12;
 
     ESP_LOGI(TAG, "Starting server on port: '%d'", config.server_port);
     if (httpd_start(&server, &config) == ESP_OK) {
@@ -83,6 +599,17 @@ httpd_handle_t start_webserver(void)
         httpd_register_uri_handler(server, &th_sensor_post);
         httpd_register_uri_handler(server, &th_sensor_get);
         httpd_register_uri_handler(server, &favicon_uri);
+        httpd_register_uri_handler(server, &nodes_get);
+        httpd_register_uri_handler(server, &stats_get);
+        httpd_register_uri_handler(server, &dlog_get);
+        httpd_register_uri_handler(server, &dlog_post);
+#if CONFIG_I2C_BUS_FAULT_INJECTION
+        httpd_register_uri_handler(server, &i2c_fault_post);
+#endif
+#if CONFIG_CAPTURE_ENABLE
+        httpd_register_uri_handler(server, &capture_get);
+        httpd_register_uri_handler(server, &capture_post);
+#endif
         return server;
     }
 
@@ -2,6 +2,9 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "i2c_bus.h"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "sdkconfig.h"
 #include "esp_log.h"
 
@@ -14,11 +17,141 @@ SemaphoreHandle_t i2c_mutex = NULL;
 #define I2C_MASTER_NUM              I2C_NUM_0                   /*!< I2C port number for master dev */
 #define I2C_MASTER_FREQ_HZ          CONFIG_I2C_MASTER_FREQUENCY /*!< I2C master clock frequency */
 
+#define I2C_RECOVERY_THRESHOLD      3   /*!< Consecutive errors before a device's bus is recovered */
+#define I2C_PROBE_TIMEOUT_MS        CONFIG_I2C_PROBE_TIMEOUT_MS
+#define I2C_BUS_CLEAR_PULSES        9   /*!< Enough for a slave to finish any byte it is stuck in */
+#define I2C_BUS_CLEAR_HALF_US       5   /*!< Half SCL period, 100 kHz */
+#define I2C_VERIFY_ROUNDS           20  /*!< Clean read-backs needed to accept a clock rate */
+#define I2C_FALLBACK_WINDOW         CONFIG_I2C_FALLBACK_WINDOW
+#define I2C_FALLBACK_ERROR_PCT      CONFIG_I2C_FALLBACK_ERROR_PCT
+#define I2C_RESTORE_WINDOWS         CONFIG_I2C_RESTORE_WINDOWS
+
+// Standard-mode, Fast-mode, Fast-mode Plus
+static const uint32_t speed_steps[] = { 100000, 400000, 1000000 };
+#define I2C_SPEED_STEPS             ((int)(sizeof(speed_steps) / sizeof(speed_steps[0])))
+
 i2c_master_bus_handle_t i2c_bus = NULL;
 i2c_master_dev_handle_t i2c_dev_th_sensor = NULL; // temparature and humidity sensor
 i2c_master_dev_handle_t i2c_dev_display = NULL;
 i2c_master_dev_handle_t i2c_dev_accelerometer = NULL; // LIS3DH
 
+static esp_err_t verify_th_sensor(i2c_master_dev_handle_t dev);
+static esp_err_t verify_display(i2c_master_dev_handle_t dev);
+static esp_err_t verify_accelerometer(i2c_master_dev_handle_t dev);
+
+typedef struct {
+    const char *name;
+    i2c_master_dev_handle_t *handle;
+    i2c_device_config_t config;         /*!< scl_speed_hz is the device's current clock */
+    uint32_t max_speed_hz;              /*!< Upper bound for calibration */
+    int timeout_ms;                     /*!< Per-transfer timeout */
+    esp_err_t (*verify)(i2c_master_dev_handle_t dev);
+    void (*reinit)(void);
+    i2c_dev_stats_t stats;
+#if CONFIG_I2C_AUTO_TUNE
+    uint32_t calibrated_hz;             /*!< Ceiling for raising the clock after a fallback */
+    uint32_t window_transfers;
+    uint32_t window_errors;
+    uint32_t clean_windows;             /*!< Error-free windows in a row */
+#endif
+#if CONFIG_I2C_BUS_FAULT_INJECTION
+    uint32_t inject_count;
+    esp_err_t inject_err;
+#endif
+} i2c_dev_entry_t;
+
+static i2c_dev_entry_t devices[I2C_DEV_COUNT] = {
+    [I2C_DEV_TH_SENSOR] = {
+        .name = "th_sensor",
+        .handle = &i2c_dev_th_sensor,
+        .config = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = 0x38,
+            .scl_speed_hz = I2C_MASTER_FREQ_HZ,
+            .scl_wait_us = 0,   // driver default
+        },
+        .max_speed_hz = CONFIG_I2C_TH_SENSOR_MAX_HZ,
+        .timeout_ms = CONFIG_I2C_TH_SENSOR_TIMEOUT_MS,
+        .verify = verify_th_sensor,
+    },
+    [I2C_DEV_DISPLAY] = {
+        .name = "display",
+        .handle = &i2c_dev_display,
+        .config = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = 0x3c,
+            .scl_speed_hz = I2C_MASTER_FREQ_HZ,
+            .scl_wait_us = CONFIG_I2C_SCL_WAIT_US,
+            .flags = {
+                .disable_ack_check = false
+            }
+        },
+        .max_speed_hz = CONFIG_I2C_DISPLAY_MAX_HZ,
+        .timeout_ms = CONFIG_I2C_DISPLAY_TIMEOUT_MS,
+        .verify = verify_display,
+    },
+    [I2C_DEV_ACCELEROMETER] = {
+        .name = "accelerometer",
+        .handle = &i2c_dev_accelerometer,
+        .config = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = 0x19,
+            .scl_speed_hz = I2C_MASTER_FREQ_HZ,
+            .scl_wait_us = CONFIG_I2C_SCL_WAIT_US,
+            .flags = {
+                .disable_ack_check = false
+            }
+        },
+        .max_speed_hz = CONFIG_I2C_ACCELEROMETER_MAX_HZ,
+        .timeout_ms = CONFIG_I2C_ACCELEROMETER_TIMEOUT_MS,
+        .verify = verify_accelerometer,
+    },
+};
+
+// Set while re-initializing devices, so their init traffic can't trigger a nested recovery
+static bool recovering = false;
+
+static const i2c_master_bus_config_t bus_config = {
+    .i2c_port = I2C_MASTER_NUM,
+    .sda_io_num = I2C_MASTER_SDA_IO,
+    .scl_io_num = I2C_MASTER_SCL_IO,
+    .clk_source = I2C_CLK_SRC_DEFAULT,
+    .glitch_ignore_cnt = 7,
+    .flags.enable_internal_pullup = true,
+};
+
+static esp_err_t i2c_bus_create(void)
+{
+    esp_err_t err = i2c_new_master_bus(&bus_config, &i2c_bus);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    for (int i = 0; i < I2C_DEV_COUNT; i++) {
+        devices[i].stats.scl_speed_hz = devices[i].config.scl_speed_hz;
+        err = i2c_master_bus_add_device(i2c_bus, &devices[i].config, devices[i].handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to add %s: %s", devices[i].name, esp_err_to_name(err));
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+static void i2c_bus_destroy(void)
+{
+    for (int i = 0; i < I2C_DEV_COUNT; i++) {
+        if (*devices[i].handle) {
+            i2c_master_bus_rm_device(*devices[i].handle);
+            *devices[i].handle = NULL;
+        }
+    }
+    if (i2c_bus) {
+        i2c_del_master_bus(i2c_bus);
+        i2c_bus = NULL;
+    }
+}
+
 void i2c_master_init(void)
 {
     i2c_mutex = xSemaphoreCreateMutex();
@@ -29,16 +162,6 @@ void i2c_master_init(void)
     }
     ESP_LOGI(TAG, "Created i2c_mutex");
 
-    i2c_master_bus_config_t bus_config = {
-        .i2c_port = I2C_MASTER_NUM,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .clk_source = I2C_CLK_SRC_DEFAULT,
-        .glitch_ignore_cnt = 7,
-        .flags.enable_internal_pullup = true,
-    };
-    ESP_ERROR_CHECK(i2c_new_master_bus(&bus_config, &i2c_bus));
-
     // Discover devices
     // for (uint16_t i = 0; i <= 127; i++) {
     //     esp_err_t discover_result = i2c_master_probe(i2c_bus, i, 100);
@@ -51,38 +174,439 @@ void i2c_master_init(void)
     //     //     ESP_LOGI(TAG, "Timeout");
 	// }
 
-    // Add temperature and humidity sensor
-    i2c_device_config_t dev_config_th_sensor = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = 0x38,
-        .scl_speed_hz = I2C_MASTER_FREQ_HZ,
-    };
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus, &dev_config_th_sensor, &i2c_dev_th_sensor));
-
-    // Add display
-    i2c_device_config_t dev_config_display = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = 0x3c,
-        .scl_speed_hz = I2C_MASTER_FREQ_HZ,
-        .scl_wait_us = 1000,
-        .flags = {
-            .disable_ack_check = false
+    // Add temperature and humidity sensor, display and accelerometer sensor
+    ESP_ERROR_CHECK(i2c_bus_create());
+
+#if CONFIG_I2C_AUTO_TUNE
+    for (int i = 0; i < I2C_DEV_COUNT; i++) {
+        i2c_bus_calibrate(i);
+    }
+#endif
+#if CONFIG_I2C_BUS_BENCHMARK
+    i2c_bus_benchmark();
+#endif
+}
+
+/*
+ * Read-back checks used to qualify a clock rate. Each must exercise the
+ * device's data path, not just the address ACK.
+ */
+
+// AHT20: status byte, bit 7 (busy) clear when idle. Calibration (bit 3) is
+// not checked, th_sensor_init() has not run yet.
+static esp_err_t verify_th_sensor(i2c_master_dev_handle_t dev)
+{
+    uint8_t status;
+    esp_err_t err = i2c_master_receive(dev, &status, 1, I2C_PROBE_TIMEOUT_MS);
+    if (err == ESP_OK && (status & 0x80)) {
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+    return err;
+}
+
+// SSD1306: write-only over I2C, so the best check is an ACKed NOP command
+static esp_err_t verify_display(i2c_master_dev_handle_t dev)
+{
+    const uint8_t nop[] = { 0x00, 0xe3 };
+    return i2c_master_transmit(dev, nop, sizeof(nop), I2C_PROBE_TIMEOUT_MS);
+}
+
+// LIS3DH: WHO_AM_I (0x0f) reads 0x33
+static esp_err_t verify_accelerometer(i2c_master_dev_handle_t dev)
+{
+    uint8_t reg = 0x0f, who_am_i;
+    esp_err_t err = i2c_master_transmit_receive(dev, &reg, 1, &who_am_i, 1, I2C_PROBE_TIMEOUT_MS);
+    if (err == ESP_OK && who_am_i != 0x33) {
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+    return err;
+}
+
+/**
+ * @brief Re-add a device to the bus with a new SCL rate.
+ */
+static esp_err_t i2c_dev_set_speed(i2c_dev_id_t dev, uint32_t speed_hz)
+{
+    i2c_dev_entry_t *entry = &devices[dev];
+
+    if (*entry->handle) {
+        i2c_master_bus_rm_device(*entry->handle);
+        *entry->handle = NULL;
+    }
+    entry->config.scl_speed_hz = speed_hz;
+    entry->stats.scl_speed_hz = speed_hz;
+    return i2c_master_bus_add_device(i2c_bus, &entry->config, entry->handle);
+}
+
+uint32_t i2c_bus_calibrate(i2c_dev_id_t dev)
+{
+    i2c_dev_entry_t *entry = &devices[dev];
+    uint32_t good = 0;
+
+    for (int step = 0; step < I2C_SPEED_STEPS && speed_steps[step] <= entry->max_speed_hz; step++) {
+        if (i2c_dev_set_speed(dev, speed_steps[step]) != ESP_OK) {
+            break;
         }
-    };
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus, &dev_config_display, &i2c_dev_display));
-
-    // Add accelerometer sensor
-    i2c_device_config_t dev_config_accelerometer = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = 0x19,
-        .scl_speed_hz = I2C_MASTER_FREQ_HZ,
-        .scl_wait_us = 1000,
-        .flags = {
-            .disable_ack_check = false
+
+        int round = 0;
+        esp_err_t err = ESP_OK;
+        while (round < I2C_VERIFY_ROUNDS && (err = entry->verify(*entry->handle)) == ESP_OK) {
+            round++;
+        }
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "%s: %lu Hz failed after %d reads (%s)", entry->name,
+                     (unsigned long)speed_steps[step], round, esp_err_to_name(err));
+            // A failed transfer can leave a slave holding SDA
+            i2c_master_bus_reset(i2c_bus);
+            break;
+        }
+        good = speed_steps[step];
+    }
+
+    if (good == 0) {
+        // Nothing verified, not even Standard-mode: leave it at the configured default
+        good = I2C_MASTER_FREQ_HZ;
+        ESP_LOGE(TAG, "%s: no clock rate verified, using %lu Hz", entry->name, (unsigned long)good);
+    } else {
+        ESP_LOGI(TAG, "%s: running at %lu Hz", entry->name, (unsigned long)good);
+    }
+    i2c_dev_set_speed(dev, good);
+#if CONFIG_I2C_AUTO_TUNE
+    entry->calibrated_hz = good;
+    entry->window_transfers = 0;
+    entry->window_errors = 0;
+    entry->clean_windows = 0;
+#endif
+    return good;
+}
+
+#if CONFIG_I2C_AUTO_TUNE
+/**
+ * @brief Drop a device one clock step.
+ * @return true if the speed was lowered
+ */
+static bool i2c_dev_step_down(i2c_dev_id_t dev)
+{
+    i2c_dev_entry_t *entry = &devices[dev];
+    uint32_t lower = 0;
+
+    for (int step = 0; step < I2C_SPEED_STEPS; step++) {
+        if (speed_steps[step] < entry->config.scl_speed_hz) {
+            lower = speed_steps[step];
         }
+    }
+    if (lower == 0) {
+        return false;
+    }
+
+    ESP_LOGW(TAG, "%s: falling back to %lu Hz", entry->name, (unsigned long)lower);
+    entry->stats.speed_fallbacks++;
+    return i2c_dev_set_speed(dev, lower) == ESP_OK;
+}
+
+/**
+ * @brief Raise a device one clock step, never past its calibrated rate.
+ * @return true if the speed was raised
+ */
+static bool i2c_dev_step_up(i2c_dev_id_t dev)
+{
+    i2c_dev_entry_t *entry = &devices[dev];
+    uint32_t higher = 0;
+
+    for (int step = I2C_SPEED_STEPS - 1; step >= 0; step--) {
+        if (speed_steps[step] > entry->config.scl_speed_hz && speed_steps[step] <= entry->calibrated_hz) {
+            higher = speed_steps[step];
+        }
+    }
+    if (higher == 0) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "%s: clean for %d windows, back to %lu Hz", entry->name,
+             I2C_RESTORE_WINDOWS, (unsigned long)higher);
+    entry->stats.speed_restores++;
+    return i2c_dev_set_speed(dev, higher) == ESP_OK;
+}
+
+/**
+ * @brief Close a window of transfers once it is full and adjust the clock.
+ *
+ * A window whose error share reaches I2C_FALLBACK_ERROR_PCT lowers the
+ * clock one step; I2C_RESTORE_WINDOWS error-free windows in a row raise it
+ * one step towards the calibrated rate. Occasional errors in between leave
+ * the clock alone.
+ */
+static void i2c_dev_update_window(i2c_dev_id_t dev, bool failed)
+{
+    i2c_dev_entry_t *entry = &devices[dev];
+
+    entry->window_transfers++;
+    entry->window_errors += failed;
+    if (entry->window_transfers < I2C_FALLBACK_WINDOW) {
+        return;
+    }
+
+    uint32_t errors = entry->window_errors;
+    entry->window_transfers = 0;
+    entry->window_errors = 0;
+
+    if (errors * 100 >= (uint32_t)I2C_FALLBACK_ERROR_PCT * I2C_FALLBACK_WINDOW) {
+        entry->clean_windows = 0;
+        i2c_dev_step_down(dev);
+    } else if (errors == 0 && ++entry->clean_windows >= I2C_RESTORE_WINDOWS) {
+        entry->clean_windows = 0;
+        i2c_dev_step_up(dev);
+    } else if (errors > 0) {
+        entry->clean_windows = 0;
+    }
+}
+#endif
+
+/**
+ * @brief Free a slave that is holding SDA low by clocking SCL by hand.
+ *
+ * A slave interrupted mid-byte (e.g. by a reset of the master) keeps driving
+ * SDA until it has shifted out the rest of its byte. Up to nine SCL pulses
+ * let it finish, then a STOP condition returns the bus to idle. The bus must
+ * be deleted first so the pins are free.
+ */
+static void i2c_bus_clear(void)
+{
+    gpio_config_t io = {
+        .pin_bit_mask = (1ULL << I2C_MASTER_SCL_IO) | (1ULL << I2C_MASTER_SDA_IO),
+        .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
     };
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus, &dev_config_accelerometer, &i2c_dev_accelerometer));
+    gpio_config(&io);
+    gpio_set_level(I2C_MASTER_SDA_IO, 1);
+    gpio_set_level(I2C_MASTER_SCL_IO, 1);
+    esp_rom_delay_us(I2C_BUS_CLEAR_HALF_US);
+
+    for (int i = 0; i < I2C_BUS_CLEAR_PULSES && !gpio_get_level(I2C_MASTER_SDA_IO); i++) {
+        gpio_set_level(I2C_MASTER_SCL_IO, 0);
+        esp_rom_delay_us(I2C_BUS_CLEAR_HALF_US);
+        gpio_set_level(I2C_MASTER_SCL_IO, 1);
+        esp_rom_delay_us(I2C_BUS_CLEAR_HALF_US);
+    }
+
+    // STOP: SDA rises while SCL is high
+    gpio_set_level(I2C_MASTER_SCL_IO, 0);
+    gpio_set_level(I2C_MASTER_SDA_IO, 0);
+    esp_rom_delay_us(I2C_BUS_CLEAR_HALF_US);
+    gpio_set_level(I2C_MASTER_SCL_IO, 1);
+    esp_rom_delay_us(I2C_BUS_CLEAR_HALF_US);
+    gpio_set_level(I2C_MASTER_SDA_IO, 1);
+    esp_rom_delay_us(I2C_BUS_CLEAR_HALF_US);
+
+    gpio_reset_pin(I2C_MASTER_SCL_IO);
+    gpio_reset_pin(I2C_MASTER_SDA_IO);
+}
+
+static esp_err_t i2c_dev_probe(i2c_dev_id_t dev)
+{
+#if CONFIG_I2C_BUS_FAULT_INJECTION
+    if (devices[dev].inject_count > 0) {
+        return devices[dev].inject_err;
+    }
+#endif
+    return i2c_master_probe(i2c_bus, devices[dev].config.device_address, I2C_PROBE_TIMEOUT_MS);
+}
+
+esp_err_t i2c_bus_recover(i2c_dev_id_t dev)
+{
+    i2c_dev_entry_t *entry = &devices[dev];
+    int64_t start = esp_timer_get_time();
+
+    // Step 1: reset the controller and let the driver clear the bus
+    esp_err_t err = i2c_master_bus_reset(i2c_bus);
+    if (err == ESP_OK) {
+        err = i2c_dev_probe(dev);
+    }
+
+    // Step 2: tear the bus down, clock the slaves free by hand and rebuild it
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s still failing after bus reset, clearing bus", entry->name);
+        i2c_bus_destroy();
+        i2c_bus_clear();
+        err = i2c_bus_create();
+        if (err == ESP_OK) {
+            err = i2c_dev_probe(dev);
+        }
+    }
+
+    // Step 3: bring device state back, a brown-out may have reset it
+    if (err == ESP_OK && entry->reinit) {
+        recovering = true;
+        entry->reinit();
+        recovering = false;
+    }
+
+    uint32_t duration = (uint32_t)(esp_timer_get_time() - start);
+    entry->stats.last_recovery_us = start;
+    entry->stats.last_recovery_duration_us = duration;
+    if (duration > entry->stats.max_recovery_duration_us) {
+        entry->stats.max_recovery_duration_us = duration;
+    }
+    if (err == ESP_OK) {
+        entry->stats.recoveries++;
+        entry->stats.consecutive_errors = 0;
+        ESP_LOGI(TAG, "Recovered %s in %lu us", entry->name, (unsigned long)duration);
+    } else {
+        entry->stats.failed_recoveries++;
+        ESP_LOGE(TAG, "Recovery of %s failed: %s", entry->name, esp_err_to_name(err));
+    }
+    return err;
+}
+
+/**
+ * @brief Account for a finished transfer and recover the bus if it keeps failing.
+ */
+static esp_err_t i2c_dev_account(i2c_dev_id_t dev, esp_err_t err)
+{
+    i2c_dev_stats_t *stats = &devices[dev].stats;
+
+    stats->transfers++;
+#if CONFIG_I2C_AUTO_TUNE
+    // Re-init traffic during a recovery says little about the clock
+    if (!recovering) {
+        i2c_dev_update_window(dev, err != ESP_OK);
+    }
+#endif
+    if (err == ESP_OK) {
+        stats->consecutive_errors = 0;
+        return ESP_OK;
+    }
+
+    stats->errors++;
+    stats->consecutive_errors++;
+    ESP_LOGW(TAG, "%s transfer failed: %s (%lu in a row)", devices[dev].name,
+             esp_err_to_name(err), (unsigned long)stats->consecutive_errors);
+
+    // Retry recovery every few failures rather than on each one
+    if (!recovering && stats->consecutive_errors % I2C_RECOVERY_THRESHOLD == 0) {
+        i2c_bus_recover(dev);
+    }
+    // The caller's data is lost either way; let it retry on its next cycle
+    return err;
+}
+
+#if CONFIG_I2C_BUS_FAULT_INJECTION
+static bool i2c_dev_take_fault(i2c_dev_id_t dev, esp_err_t *err)
+{
+    if (devices[dev].inject_count == 0) {
+        return false;
+    }
+    devices[dev].inject_count--;
+    *err = devices[dev].inject_err;
+    return true;
+}
+
+void i2c_bus_inject_fault(i2c_dev_id_t dev, uint32_t count, esp_err_t err)
+{
+    devices[dev].inject_count = count;
+    devices[dev].inject_err = err;
+}
+#else
+static inline bool i2c_dev_take_fault(i2c_dev_id_t dev, esp_err_t *err)
+{
+    return false;
+}
+#endif
+
+esp_err_t i2c_bus_transmit(i2c_dev_id_t dev, const uint8_t *buf, size_t len)
+{
+    esp_err_t err;
+    if (!i2c_dev_take_fault(dev, &err)) {
+        err = i2c_master_transmit(*devices[dev].handle, buf, len, devices[dev].timeout_ms);
+    }
+    return i2c_dev_account(dev, err);
+}
+
+esp_err_t i2c_bus_receive(i2c_dev_id_t dev, uint8_t *buf, size_t len)
+{
+    esp_err_t err;
+    if (!i2c_dev_take_fault(dev, &err)) {
+        err = i2c_master_receive(*devices[dev].handle, buf, len, devices[dev].timeout_ms);
+    }
+    return i2c_dev_account(dev, err);
+}
+
+esp_err_t i2c_bus_transmit_receive(i2c_dev_id_t dev, const uint8_t *write_buf, size_t write_len,
+                                   uint8_t *read_buf, size_t read_len)
+{
+    esp_err_t err;
+    if (!i2c_dev_take_fault(dev, &err)) {
+        err = i2c_master_transmit_receive(*devices[dev].handle, write_buf, write_len,
+                                          read_buf, read_len, devices[dev].timeout_ms);
+    }
+    return i2c_dev_account(dev, err);
+}
+
+void i2c_bus_set_reinit(i2c_dev_id_t dev, void (*reinit)(void))
+{
+    devices[dev].reinit = reinit;
+}
+
+void i2c_bus_get_stats(i2c_dev_id_t dev, i2c_dev_stats_t *out)
+{
+    *out = devices[dev].stats;
+}
+
+const char *i2c_bus_dev_name(i2c_dev_id_t dev)
+{
+    return devices[dev].name;
+}
+
+#if CONFIG_I2C_BUS_BENCHMARK
+#define BENCH_ROUNDS 50
+
+/**
+ * @brief Time the transfer each device actually does and log payload bytes/s.
+ *
+ * display:       one 128-byte GDDRAM data write (a page of a frame push)
+ * accelerometer: 6-byte OUT_X_L..OUT_Z_H burst read
+ * th_sensor:     6-byte measurement read
+ *
+ * Runs before the display is initialized, so the zeroed page is not visible.
+ */
+void i2c_bus_benchmark(void)
+{
+    static uint8_t page[129] = { 0x40 };    // Co = 0, D/C# = 1: data bytes follow
+    uint8_t reg = 0x28 | 0x80, buf[6];
+
+    for (int dev = 0; dev < I2C_DEV_COUNT; dev++) {
+        i2c_master_dev_handle_t handle = *devices[dev].handle;
+        size_t payload = 0;
+        int ok = 0;
+
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < BENCH_ROUNDS; i++) {
+            esp_err_t err;
+            switch (dev) {
+                case I2C_DEV_DISPLAY:
+                    payload = sizeof(page) - 1;
+                    err = i2c_master_transmit(handle, page, sizeof(page), I2C_PROBE_TIMEOUT_MS);
+                    break;
+                case I2C_DEV_ACCELEROMETER:
+                    payload = sizeof(buf);
+                    err = i2c_master_transmit_receive(handle, &reg, 1, buf, sizeof(buf), I2C_PROBE_TIMEOUT_MS);
+                    break;
+                default:
+                    payload = sizeof(buf);
+                    err = i2c_master_receive(handle, buf, sizeof(buf), I2C_PROBE_TIMEOUT_MS);
+                    break;
+            }
+            ok += err == ESP_OK;
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        ESP_LOGI(TAG, "%s @ %lu Hz: %d/%d ok, %lu us/transfer, %.0f B/s",
+                 devices[dev].name, (unsigned long)devices[dev].config.scl_speed_hz,
+                 ok, BENCH_ROUNDS, (unsigned long)(elapsed / BENCH_ROUNDS),
+                 elapsed ? ok * payload * 1e6 / elapsed : 0.0);
+    }
 }
+#endif
 
 // i2c_bus: Found device 19 - accelerometer
 // i2c_bus: Found device 38 - th_sensor
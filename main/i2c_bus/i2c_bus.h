@@ -5,6 +5,7 @@
 #include "freertos/semphr.h"
 #include "driver/i2c_master.h"
 #include "esp_err.h"
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,6 +13,27 @@ extern "C" {
 
 extern SemaphoreHandle_t i2c_mutex;
 
+typedef enum {
+    I2C_DEV_TH_SENSOR,
+    I2C_DEV_DISPLAY,
+    I2C_DEV_ACCELEROMETER,
+    I2C_DEV_COUNT,
+} i2c_dev_id_t;
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t errors;
+    uint32_t consecutive_errors;
+    uint32_t recoveries;                    /*!< Recoveries after which the device answered again */
+    uint32_t failed_recoveries;
+    int64_t last_recovery_us;               /*!< Uptime at the start of the last recovery */
+    uint32_t last_recovery_duration_us;
+    uint32_t max_recovery_duration_us;
+    uint32_t scl_speed_hz;                  /*!< Current clock of this device */
+    uint32_t speed_fallbacks;               /*!< Times the clock was lowered after errors */
+    uint32_t speed_restores;                /*!< Times the clock was raised again after a clean period */
+} i2c_dev_stats_t;
+
 extern i2c_master_bus_handle_t i2c_bus;
 extern i2c_master_dev_handle_t i2c_dev_th_sensor;
 extern i2c_master_dev_handle_t i2c_dev_display;
@@ -23,6 +45,75 @@ extern i2c_master_dev_handle_t i2c_dev_accelerometer;
 void i2c_master_init(void);
 void i2c_discover(void);
 
+/**
+ * @brief Transfer wrappers around the i2c_master API for a known device.
+ *
+ * Errors are counted per device; after several in a row the bus is recovered
+ * in place (see i2c_bus_recover). The failed transfer's error is still
+ * returned, so callers should treat their data as stale and try again on
+ * their next cycle. Each transfer uses the timeout from the device's
+ * profile. Take `i2c_mutex` before calling.
+ */
+esp_err_t i2c_bus_transmit(i2c_dev_id_t dev, const uint8_t *buf, size_t len);
+esp_err_t i2c_bus_receive(i2c_dev_id_t dev, uint8_t *buf, size_t len);
+esp_err_t i2c_bus_transmit_receive(i2c_dev_id_t dev, const uint8_t *write_buf, size_t write_len,
+                                   uint8_t *read_buf, size_t read_len);
+
+/**
+ * @brief Recover the bus after a device stopped responding.
+ *
+ * Resets the controller with i2c_master_bus_reset(). If the device still
+ * doesn't ACK, the bus is deleted, SCL is toggled by hand until slaves
+ * release SDA, and the bus and devices are recreated. The device is then
+ * re-initialized through the routine registered with i2c_bus_set_reinit().
+ *
+ * @return ESP_OK if the device responds again
+ */
+esp_err_t i2c_bus_recover(i2c_dev_id_t dev);
+
+/**
+ * @brief Find the highest clock a device handles reliably.
+ *
+ * Steps through 100 kHz, 400 kHz and 1 MHz up to the device's configured
+ * maximum, doing a burst of read-back checks at each, and leaves the device
+ * at the last rate that passed all of them. While the bus runs, a device
+ * whose error rate over a window of transfers is too high drops one step,
+ * and moves back up after enough clean windows. Call before tasks use the
+ * bus.
+ *
+ * @return The selected SCL rate in Hz
+ */
+uint32_t i2c_bus_calibrate(i2c_dev_id_t dev);
+
+#if CONFIG_I2C_BUS_BENCHMARK
+/**
+ * @brief Log effective payload bytes/s per device at its current clock.
+ */
+void i2c_bus_benchmark(void);
+#endif
+
+/**
+ * @brief Register the driver init routine to replay after recovering `dev`.
+ */
+void i2c_bus_set_reinit(i2c_dev_id_t dev, void (*reinit)(void));
+
+/**
+ * @brief Copy the error and recovery counters of a device.
+ */
+void i2c_bus_get_stats(i2c_dev_id_t dev, i2c_dev_stats_t *out);
+
+/**
+ * @brief Short name of a device for logs and metrics.
+ */
+const char *i2c_bus_dev_name(i2c_dev_id_t dev);
+
+#if CONFIG_I2C_BUS_FAULT_INJECTION
+/**
+ * @brief Make the next `count` transfers to `dev` fail with `err`.
+ */
+void i2c_bus_inject_fault(i2c_dev_id_t dev, uint32_t count, esp_err_t err);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
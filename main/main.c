@@ -10,26 +10,82 @@
 #include "th_sensor/th_sensor.h"
 #include "accelerometer/accelerometer.h"
 #include "tasks/tasks.h"
+#include "dlog/dlog.h"
+#include "udp_exporter/udp_exporter.h"
+#include "capture/capture.h"
 
 static const char *TAG = "main";
 
+static httpd_handle_t server = NULL;
+
+/**
+ * @brief Attach network-dependent services once the station has an address.
+ *
+ * Runs in the default event loop task. The server listens on all interfaces,
+ * so it is started once and kept across reconnects.
+ */
+static void on_got_ip(void* arg, esp_event_base_t event_base,
+                      int32_t event_id, void* event_data)
+{
+    if (server) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Starting HTTP server...");
+    server = start_webserver();
+    if (!server) {
+        ESP_LOGE(TAG, "Failed to start HTTP server!");
+    }
+}
+
+/*
+ * Boot order follows dependencies rather than a single sequence:
+ *
+ *   NVS -> netif/event loop -> Wi-Fi start (non-blocking)
+ *                                  `-> IP_EVENT_STA_GOT_IP -> HTTP server
+ *   I2C bus -> display, TH sensor, accelerometer -> sensor tasks
+ *
+ * Sensing never waits for the AP, so the first sample lands within a few
+ * hundred ms of boot even when the network is down.
+ */
 void app_main(void)
 {
+    // Drain deferred log records from the sensor loops
+    dlog_init();
+#if CONFIG_DLOG_BENCHMARK
+    dlog_benchmark();
+#endif
+
     ESP_LOGI(TAG, "Initializing NVS...");
     ESP_ERROR_CHECK(nvs_flash_init());
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
-    // Connect to Wi-Fi
+    // Network services attach when the station gets an address
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+                                                        IP_EVENT_STA_GOT_IP,
+                                                        &on_got_ip,
+                                                        NULL,
+                                                        NULL));
+
+    // Start Wi-Fi; association and DHCP run in the background
     ESP_LOGI(TAG, "Connecting to Wi-Fi...");
     wifi_init_sta();
 
-    // Start HTTP server
-    ESP_LOGI(TAG, "Starting HTTP server...");
-    httpd_handle_t server = start_webserver();
-    if (!server) {
-        ESP_LOGE(TAG, "Failed to start HTTP server!");
-    }
+    // UDP telemetry; datagrams are dropped until the station has an address
+    udp_exporter_init();
+#if CONFIG_UDP_EXPORTER_BENCHMARK
+    udp_exporter_benchmark_start();
+#endif
+
+#if CONFIG_CAPTURE_REPLAY
+    // Sensors are replaced by a recorded capture
+    ESP_LOGI(TAG, "Replaying %s...", CONFIG_CAPTURE_REPLAY_PATH);
+    capture_replay_start();
+#else
+#if CONFIG_CAPTURE_ENABLE
+    capture_start();
+#endif
 
     // Initialize I2C bus and devices
     ESP_LOGI(TAG, "Initializing I2C bus...");
@@ -39,6 +95,9 @@ void app_main(void)
     ESP_LOGI(TAG, "Initializing display...");
     u8g2_display_init();
 
+    // Calibrate temperature & humidity sensor before any task uses the bus
+    th_sensor_init();
+
     // Start accelerometer sensor task
     ESP_LOGI(TAG, "Get accelerometer data...");
     accelerometer_sensor_init();
@@ -47,6 +106,7 @@ void app_main(void)
     // Start temperature & humidity sensor task
     ESP_LOGI(TAG, "Starting TH sensor task...");
     th_sensor_start_task();
+#endif
 
     // Keep main alive
     while (1) {
@@ -0,0 +1,298 @@
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "node_table.h"
+#include "fnv1a.h"
+#include "esp_log.h"
+
+static const char *TAG = "node_table";
+
+#define TEMP_MIN    -50.0f  /*!< AHT20 measuring range */
+#define TEMP_MAX    150.0f
+#define HUM_MIN     0.0f
+#define HUM_MAX     100.0f
+
+/*
+ * Open addressing table indexed by FNV-1a of the node id with linear
+ * probing. Evictions use backward-shift deletion, so probe chains stay
+ * contiguous and no tombstones are needed.
+ *
+ * Unlocked: only the HTTP server task touches the table (see node_table.h).
+ */
+static node_entry_t nodes[NODE_TABLE_CAPACITY];
+
+static uint32_t node_hash(const char *id)
+{
+    return fnv1a32_str(FNV1A32_INIT, id);
+}
+
+static char *skip_ws(char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+/**
+ * @brief Terminate a JSON string in place.
+ *
+ * `p` points just past the opening quote. Escapes are not supported, since
+ * none of the fields we accept need them.
+ *
+ * @return Pointer past the closing quote, or NULL on error
+ */
+static char *parse_string(char *p)
+{
+    while (*p && *p != '"') {
+        if (*p == '\\') return NULL;
+        p++;
+    }
+    if (*p != '"') return NULL;
+    *p = '\0';
+    return p + 1;
+}
+
+typedef struct {
+    const char *node;
+    float temperature;
+    float humidity;
+    uint32_t timestamp;
+    bool has_temperature;
+    bool has_humidity;
+} reading_t;
+
+/**
+ * @brief Parse an unsigned 32-bit JSON integer.
+ *
+ * Fractions, exponents, signs and values above UINT32_MAX are rejected
+ * rather than rounded or wrapped.
+ *
+ * @return Pointer past the number, or NULL on error
+ */
+static char *parse_u32(char *p, uint32_t *out)
+{
+    if (*p < '0' || *p > '9') return NULL;
+
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(p, &end, 10);
+    if (errno == ERANGE || value > UINT32_MAX) return NULL;
+    if (*end == '.' || *end == 'e' || *end == 'E') return NULL;
+
+    *out = value;
+    return end;
+}
+
+/**
+ * @brief Scan a flat JSON object of string and number members.
+ *
+ * Keys and string values are NUL-terminated inside `buf`, so no copies or
+ * allocations are made. Unknown numeric or string members are skipped;
+ * nested objects and arrays are rejected.
+ */
+static esp_err_t parse_reading(char *buf, reading_t *out)
+{
+    char *p = skip_ws(buf);
+    if (*p++ != '{') return ESP_ERR_INVALID_ARG;
+
+    p = skip_ws(p);
+    if (*p == '}') return ESP_ERR_INVALID_ARG;
+
+    while (1) {
+        p = skip_ws(p);
+        if (*p++ != '"') return ESP_ERR_INVALID_ARG;
+        char *key = p;
+        if (!(p = parse_string(p))) return ESP_ERR_INVALID_ARG;
+
+        p = skip_ws(p);
+        if (*p++ != ':') return ESP_ERR_INVALID_ARG;
+        p = skip_ws(p);
+
+        if (*p == '"') {
+            char *value = ++p;
+            if (!(p = parse_string(p))) return ESP_ERR_INVALID_ARG;
+            if (strcmp(key, "node") == 0) {
+                out->node = value;
+            }
+        } else if (strcmp(key, "timestamp") == 0) {
+            // Epoch seconds don't survive a float's 24-bit mantissa
+            if (!(p = parse_u32(p, &out->timestamp))) return ESP_ERR_INVALID_ARG;
+        } else {
+            char *end;
+            float value = strtof(p, &end);
+            if (end == p || !isfinite(value)) return ESP_ERR_INVALID_ARG;
+            p = end;
+
+            if (strcmp(key, "temperature") == 0) {
+                out->temperature = value;
+                out->has_temperature = true;
+            } else if (strcmp(key, "humidity") == 0) {
+                out->humidity = value;
+                out->has_humidity = true;
+            }
+        }
+
+        p = skip_ws(p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        if (*p++ != '}') return ESP_ERR_INVALID_ARG;
+        break;
+    }
+
+    return *skip_ws(p) == '\0' ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t validate_reading(const reading_t *r)
+{
+    if (!r->has_temperature || !r->has_humidity) return ESP_ERR_INVALID_ARG;
+    if (r->temperature < TEMP_MIN || r->temperature > TEMP_MAX) return ESP_ERR_INVALID_ARG;
+    if (r->humidity < HUM_MIN || r->humidity > HUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    if (!r->node) return ESP_ERR_INVALID_ARG;
+    size_t len = strlen(r->node);
+    if (len == 0 || len >= NODE_ID_MAX_LEN) return ESP_ERR_INVALID_ARG;
+    for (size_t i = 0; i < len; i++) {
+        char c = r->node[i];
+        // Ids end up in the /nodes JSON unescaped
+        if (c < 0x20 || c == '"' || c == '\\') return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Find a node's slot, or the empty slot ending its probe chain.
+ * @return Slot index, or -1 if the table is full and the node is not in it
+ */
+static int node_find(const char *id)
+{
+    uint32_t slot = node_hash(id) % NODE_TABLE_CAPACITY;
+
+    for (size_t probe = 0; probe < NODE_TABLE_CAPACITY; probe++) {
+        if (nodes[slot].id[0] == '\0' || strcmp(nodes[slot].id, id) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) % NODE_TABLE_CAPACITY;
+    }
+    return -1;
+}
+
+/**
+ * @brief Remove a slot and pull later members of its probe chain back.
+ *
+ * An entry may move into the hole unless its home slot lies cyclically in
+ * (hole, entry], in which case lookups would no longer reach it.
+ */
+static void node_remove(uint32_t hole)
+{
+    uint32_t next = hole;
+
+    // Empty the hole first, so the scan stops even when the table was full
+    memset(&nodes[hole], 0, sizeof(nodes[hole]));
+    while (1) {
+        next = (next + 1) % NODE_TABLE_CAPACITY;
+        if (nodes[next].id[0] == '\0') {
+            break;
+        }
+        uint32_t home = node_hash(nodes[next].id) % NODE_TABLE_CAPACITY;
+        bool reachable = hole <= next ? (hole < home && home <= next)
+                                      : (hole < home || home <= next);
+        if (!reachable) {
+            nodes[hole] = nodes[next];
+            memset(&nodes[next], 0, sizeof(nodes[next]));
+            hole = next;
+        }
+    }
+}
+
+/**
+ * @brief Free the slot of the node that has been silent the longest.
+ *
+ * Only nodes idle for NODE_TABLE_IDLE_MS are evicted, so a burst of new ids
+ * cannot push out nodes that are still reporting.
+ *
+ * @param now_ms   Current uptime
+ * @param evicted  Receives the evicted id, for logging
+ * @return true if a slot was freed
+ */
+static bool node_evict_idle(uint32_t now_ms, char evicted[NODE_ID_MAX_LEN])
+{
+    int oldest = -1;
+    uint32_t oldest_idle = 0;
+
+    for (int slot = 0; slot < NODE_TABLE_CAPACITY; slot++) {
+        const node_entry_t *e = &nodes[slot];
+        uint32_t idle = now_ms - e->history[e->head].received_ms;
+        if (idle >= oldest_idle) {
+            oldest = slot;
+            oldest_idle = idle;
+        }
+    }
+    if (oldest < 0 || oldest_idle < NODE_TABLE_IDLE_MS) {
+        return false;
+    }
+
+    strcpy(evicted, nodes[oldest].id);
+    node_remove(oldest);
+    return true;
+}
+
+esp_err_t node_table_ingest_json(char *buf, const char *fallback_id)
+{
+    reading_t r = { .node = fallback_id };
+    esp_err_t err = parse_reading(buf, &r);
+    if (err == ESP_OK) {
+        err = validate_reading(&r);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    node_sample_t sample = {
+        .received_ms = pdTICKS_TO_MS(xTaskGetTickCount()),
+        .timestamp = r.timestamp,
+        .temperature = r.temperature,
+        .humidity = r.humidity,
+    };
+    char evicted[NODE_ID_MAX_LEN] = "";
+
+    int slot = node_find(r.node);
+    if (slot < 0 && node_evict_idle(sample.received_ms, evicted)) {
+        slot = node_find(r.node);
+    }
+    if (slot < 0) {
+        ESP_LOGW(TAG, "Table full, dropping reading from %s", r.node);
+        return ESP_ERR_NO_MEM;
+    }
+
+    node_entry_t *e = &nodes[slot];
+    if (e->id[0] == '\0') {
+        strcpy(e->id, r.node);
+    }
+    if (e->count > 0) {
+        e->head = (e->head + 1) % NODE_TABLE_HISTORY;
+    }
+    e->history[e->head] = sample;
+    e->count++;
+
+    if (evicted[0]) {
+        ESP_LOGI(TAG, "Evicted idle node %s for %s", evicted, r.node);
+    }
+    return ESP_OK;
+}
+
+bool node_table_get(size_t slot, node_entry_t *out)
+{
+    if (slot >= NODE_TABLE_CAPACITY) {
+        return false;
+    }
+
+    bool used = nodes[slot].id[0] != '\0';
+    if (used) {
+        *out = nodes[slot];
+    }
+    return used;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NODE_TABLE_CAPACITY     32  /*!< Maximum number of peer nodes tracked */
+#define NODE_TABLE_HISTORY      8   /*!< Samples kept per node */
+#define NODE_ID_MAX_LEN         48  /*!< Including the terminating NUL, fits an IPv6 address */
+#define NODE_TABLE_IDLE_MS      (10 * 60 * 1000)    /*!< Silence after which a node may be evicted */
+
+/*
+ * The table has no lock. Every call must come from the same task, today
+ * the HTTP server's; add a mutex before calling it from anywhere else.
+ */
+
+typedef struct {
+    uint32_t received_ms;   /*!< Local uptime when the sample arrived */
+    uint32_t timestamp;     /*!< Sender's timestamp, 0 if not provided */
+    float temperature;
+    float humidity;
+} node_sample_t;
+
+typedef struct {
+    char id[NODE_ID_MAX_LEN];
+    uint32_t count;         /*!< Total samples accepted from this node */
+    uint8_t head;           /*!< Index of the latest sample in history */
+    node_sample_t history[NODE_TABLE_HISTORY];
+} node_entry_t;
+
+/**
+ * @brief Parse a flat JSON reading in place and store it in the node table.
+ *
+ * Accepts `{"node":"...","temperature":x,"humidity":y,"timestamp":t}`.
+ * `node` and `timestamp` are optional; when `node` is missing the caller's
+ * `fallback_id` (typically the peer address) is used. `timestamp` must be
+ * an integer in the uint32_t range. When the table is full, the node that
+ * has been silent longest is evicted if it has been idle for
+ * NODE_TABLE_IDLE_MS.
+ *
+ * @param buf         NUL-terminated request body, modified during parsing
+ * @param fallback_id Node id to use when the body carries none
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on malformed or out-of-range
+ *         data, ESP_ERR_NO_MEM when the table is full of active nodes
+ */
+esp_err_t node_table_ingest_json(char *buf, const char *fallback_id);
+
+/**
+ * @brief Copy the node stored in slot `slot`.
+ * @return true if the slot is occupied and `out` was filled
+ */
+bool node_table_get(size_t slot, node_entry_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,7 +4,12 @@
 #include "th_sensor.h"
 #include "i2c_bus/i2c_bus.h"
 #include "display/display.h"
+#include "wifi_manager/wifi_manager.h"
+#include "boot_metrics/boot_metrics.h"
+#include "udp_exporter/udp_exporter.h"
+#include "capture/capture.h"
 #include "esp_log.h"
+#include "dlog/dlog.h"
 #include "esp_http_client.h"
 #include "cJSON.h"
 #include "sdkconfig.h"
@@ -19,14 +24,53 @@ static const char *TAG = "th_sensor";
 float temperature = 0;
 float humidity = 0;
 
+static portMUX_TYPE th_sensor_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t th_sensor_seq = 0;
+static bool th_sensor_stale = true;
+
+/**
+ * @brief Take a consistent snapshot of the latest reading.
+ *
+ * The sequence number is bumped every time a new sample is published, so
+ * consumers can cheaply tell whether anything changed since their last look.
+ */
+uint32_t th_sensor_get_reading(float *temp, float *hum, bool *stale)
+{
+    taskENTER_CRITICAL(&th_sensor_lock);
+    uint32_t seq = th_sensor_seq;
+    if (temp) *temp = temperature;
+    if (hum) *hum = humidity;
+    if (stale) *stale = th_sensor_stale;
+    taskEXIT_CRITICAL(&th_sensor_lock);
+    return seq;
+}
+
+/**
+ * @brief Flag the published reading as stale after a failed measurement.
+ *
+ * The last good values stay published; the sequence number moves so that
+ * consumers notice the change of state.
+ */
+static void th_sensor_mark_stale(void)
+{
+    taskENTER_CRITICAL(&th_sensor_lock);
+    if (!th_sensor_stale) {
+        th_sensor_stale = true;
+        th_sensor_seq++;
+    }
+    taskEXIT_CRITICAL(&th_sensor_lock);
+}
+
 /**
  * @brief Send the latest temperature and humidity data to a server.
  *
  * Creates a JSON payload containing `temperature`, `humidity`, and `timestamp`,
  * then performs an HTTP POST request to the configured server URL.
  * Logs success or error messages accordingly.
+ *
+ * @return ESP_OK if the server accepted the data
  */
-void send_th_sensor_data(void)
+esp_err_t send_th_sensor_data(void)
 {
     cJSON *json = cJSON_CreateObject();
     cJSON_AddNumberToObject(json, "temperature", temperature);
@@ -46,7 +90,7 @@ void send_th_sensor_data(void)
         .url = SERVER_URL,
         .method = HTTP_METHOD_POST,
     };
-    ESP_LOGI(TAG, "HTTP request with url => %s", SERVER_URL);
+    DLOGD(TAG, "HTTP request with url => %s", SERVER_URL);
     esp_http_client_handle_t client = esp_http_client_init(&config);
     esp_http_client_set_method(client, HTTP_METHOD_POST);
     esp_http_client_set_header(client, "Content-Type", "application/json");
@@ -56,9 +100,10 @@ void send_th_sensor_data(void)
     if (err == ESP_OK) {
         int status = esp_http_client_get_status_code(client);
         if (status == 200 || status == 201) {
-            ESP_LOGI(TAG, "Data accepted by server");
+            DLOGI(TAG, "Data accepted by server");
         } else {
             ESP_LOGW(TAG, "Server responded with %d", status);
+            err = ESP_FAIL;
         }
     } else {
         ESP_LOGE(TAG, "HTTP error: %s", esp_err_to_name(err));
@@ -67,6 +112,28 @@ void send_th_sensor_data(void)
     esp_http_client_cleanup(client);
     cJSON_Delete(json);
     free(payload);
+    return err;
+}
+
+/**
+ * @brief Soft-reset and calibrate the AHT20.
+ *
+ * Also registered with i2c_bus as the device's re-init routine, so it runs
+ * again after a bus recovery.
+ */
+void th_sensor_init(void)
+{
+    // 0xBA → soft reset
+    uint8_t reset_cmd = 0xba;
+    i2c_bus_transmit(I2C_DEV_TH_SENSOR, &reset_cmd, 1);
+    vTaskDelay(pdMS_TO_TICKS(20));
+
+    // 0xBE → initialize/calibrate; 0x08 → command parameter; 0x00 → command parameter
+    uint8_t init_cmd[] = {0xbe, 0x08, 0x00};
+    i2c_bus_transmit(I2C_DEV_TH_SENSOR, init_cmd, 3);
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    i2c_bus_set_reinit(I2C_DEV_TH_SENSOR, th_sensor_init);
 }
 
 /**
@@ -74,24 +141,54 @@ void send_th_sensor_data(void)
  *
  * This function sends the measurement command to the sensor,
  * reads raw data, converts it to physical values, and stores them
- * in the static variables `temperature` and `humidity`.
+ * in the static variables `temperature` and `humidity`. On a bus error the
+ * previous values are kept and flagged as stale.
+ *
+ * @return ESP_OK on success, or the I2C error
  */
-void get_th_sensor_data(void)
+esp_err_t get_th_sensor_data(void)
 {
     // 0xAC → trigger measurement; 0x33 → command parameter; 0x00 → command parameter
     uint8_t write_buf[] = {0xac, 0x33, 0x00};
     uint8_t read_buf[6];
-    ESP_ERROR_CHECK(i2c_master_transmit(i2c_dev_th_sensor, write_buf, 3, 50));
-    vTaskDelay(pdMS_TO_TICKS(10));
-    ESP_ERROR_CHECK(i2c_master_receive(i2c_dev_th_sensor, read_buf, 6, 50));
+    esp_err_t err = i2c_bus_transmit(I2C_DEV_TH_SENSOR, write_buf, 3);
+    if (err == ESP_OK) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        err = i2c_bus_receive(I2C_DEV_TH_SENSOR, read_buf, 6);
+    }
+    if (err != ESP_OK) {
+        th_sensor_mark_stale();
+        return err;
+    }
 
+    capture_record(CAPTURE_SRC_TH_SENSOR, read_buf, sizeof(read_buf));
+    th_sensor_process_raw(read_buf);
+    return ESP_OK;
+}
+
+/**
+ * @brief Convert a raw AHT20 measurement and publish it.
+ *
+ * Shared by the I2C path and capture replay, so replayed payloads go
+ * through exactly the same arithmetic.
+ */
+void th_sensor_process_raw(const uint8_t read_buf[TH_SENSOR_RAW_LEN])
+{
     uint32_t hum_raw = (read_buf[1] << 16 | read_buf[2] << 8 | read_buf[3]) >> 4;
     uint32_t temp_raw = (read_buf[3] << 16 | read_buf[4] << 8 | read_buf[5]) & 0xfffff;
+    // Soft-float on the ESP32, keep it outside the critical section
+    float temp = temp_raw * 200.0 / (1024*1024) - 50;
+    float hum = hum_raw * 100.0 / (1024*1024);
 
-    temperature = temp_raw * 200.0 / (1024*1024) - 50;
-    humidity = hum_raw * 100.0 / (1024*1024);
+    taskENTER_CRITICAL(&th_sensor_lock);
+    temperature = temp;
+    humidity = hum;
+    th_sensor_stale = false;
+    th_sensor_seq++;
+    taskEXIT_CRITICAL(&th_sensor_lock);
+    boot_metrics_mark_first_sample(TAG);
 
-    ESP_LOGI(TAG, "Temp: %.1f; Humid: %.1f", temperature, humidity);
+    DLOGI(TAG, "Temp: %.1f; Humid: %.1f", temp, hum);
 }
 
 /**
@@ -99,6 +196,7 @@ void get_th_sensor_data(void)
  *        and sends the data to the server.
  *
  * The task loops indefinitely with a 2-second delay between iterations.
+ * Uploads are skipped while Wi-Fi is not connected.
  *
  * @param pvParameters Not used.
  */
@@ -109,12 +207,28 @@ void th_sensor_update_task(void *pvParameters)
         vTaskDelete(NULL);
     }
 
+    bool uploading = true;
     while(1) {
         xSemaphoreTake(i2c_mutex, portMAX_DELAY);
-        get_th_sensor_data();
+        esp_err_t err = get_th_sensor_data();
         display_th_sensor_data(temperature, humidity);
         xSemaphoreGive(i2c_mutex);
-        send_th_sensor_data();
+        if (err != ESP_OK) {
+            // Don't upload the previous reading again
+            vTaskDelay(pdMS_TO_TICKS(2000));
+            continue;
+        }
+        udp_exporter_push(UDP_EXPORTER_CH_TH, (const float[]){ temperature, humidity });
+        // Keep sampling while offline; only the upload waits for the network
+        bool online = wifi_is_connected();
+        if (online != uploading) {
+            ESP_LOGI(TAG, "Uploads %s (wifi %s)", online ? "resumed" : "paused",
+                     wifi_conn_state_name(wifi_get_state()));
+            uploading = online;
+        }
+        if (online) {
+            send_th_sensor_data();
+        }
         vTaskDelay(pdMS_TO_TICKS(2000));
     }
 }
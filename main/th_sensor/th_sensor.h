@@ -1,23 +1,49 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define TH_SENSOR_RAW_LEN 6   /*!< Status byte + 20-bit humidity + 20-bit temperature */
+
 extern float temperature;
 extern float humidity;
 
+/**
+ * @brief Copy out the latest temperature & humidity as one consistent pair.
+ * @param temp Destination for temperature in °C (may be NULL)
+ * @param hum  Destination for relative humidity in % (may be NULL)
+ * @param stale Set if the last measurement failed and the values are old (may be NULL)
+ * @return Sequence number of the sample, incremented on every new reading
+ *         and when the stale flag changes
+ */
+uint32_t th_sensor_get_reading(float *temp, float *hum, bool *stale);
+
+/**
+ * @brief Soft-reset and calibrate the sensor; take `i2c_mutex` if tasks are running.
+ */
+void th_sensor_init(void);
+
 /**
  * @brief Send temperature & humidity to a server
+ * @return ESP_OK if the server accepted the data
  */
-void send_th_sensor_data(void);
+esp_err_t send_th_sensor_data(void);
 
 /**
  * @brief Read temperature and humidity data from the sensor over I2C.
+ * @return ESP_OK on success; on failure the previous reading is flagged stale
+ */
+esp_err_t get_th_sensor_data(void);
+
+/**
+ * @brief Convert a raw measurement payload and publish it as the latest reading.
  */
-void get_th_sensor_data(void);
+void th_sensor_process_raw(const uint8_t raw[TH_SENSOR_RAW_LEN]);
 
 /**
  * @brief FreeRTOS task that periodically reads sensor data, updates the display,
@@ -0,0 +1,434 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "udp_exporter.h"
+#include "wifi_manager/wifi_manager.h"
+#include "th_sensor/th_sensor.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#if CONFIG_UDP_EXPORTER_ENABLE
+
+#define UDP_EXPORTER_SNTP   (CONFIG_UDP_EXPORTER_FORMAT_LINE && !CONFIG_IDF_TARGET_LINUX)
+#if UDP_EXPORTER_SNTP
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_netif_sntp.h"
+#endif
+
+static const char *TAG = "udp_exporter";
+
+#define PAYLOAD_SIZE        CONFIG_UDP_EXPORTER_PAYLOAD_SIZE
+#define FLUSH_TICKS         pdMS_TO_TICKS(CONFIG_UDP_EXPORTER_FLUSH_MS)
+#define SAMPLE_TEXT_MAX     160
+#define NODE_ID_MAX         32          /*!< Longest CONFIG_UDP_EXPORTER_NODE_ID, before escaping */
+#define EPOCH_VALID_AFTER   1600000000  /*!< Wall clock below this was never synced */
+
+/*
+ * Binary framing, all little endian:
+ *
+ *   header:  'S' 'K' version count  seq:u32  base_ms:u32
+ *   record:  channel:u8 nfields:u8 dt_ms:u16  value:f32 * nfields
+ *
+ * `base_ms` is the uptime of the first record, `dt_ms` is relative to it.
+ * `seq` increments by one per datagram, including ones dropped on the
+ * device, so gaps at the receiver count every datagram lost.
+ */
+#define BIN_VERSION         1
+#define BIN_HEADER_SIZE     12
+#define BIN_COUNT_OFFSET    3
+
+typedef struct {
+    uint8_t channel;
+    uint8_t nfields;
+    int64_t uptime_us;
+    float values[UDP_EXPORTER_MAX_FIELDS];
+} udp_sample_t;
+
+typedef struct {
+    const char *name;
+    uint8_t nfields;
+    const char *fields[UDP_EXPORTER_MAX_FIELDS];
+} udp_channel_desc_t;
+
+static const udp_channel_desc_t channels[UDP_EXPORTER_CH_COUNT] = {
+    [UDP_EXPORTER_CH_TH]    = { "th_sensor", 2, { "temperature", "humidity" } },
+    [UDP_EXPORTER_CH_ACCEL] = { "accelerometer", 3, { "x", "y", "z" } },
+};
+
+static QueueHandle_t sample_queue = NULL;
+static int sock = -1;
+static struct sockaddr_in dest;
+
+#if CONFIG_UDP_EXPORTER_FORMAT_LINE
+_Static_assert(sizeof(CONFIG_UDP_EXPORTER_NODE_ID) <= NODE_ID_MAX + 1,
+               "UDP_EXPORTER_NODE_ID is longer than NODE_ID_MAX");
+
+// ",node=<id>" with the id escaped as a tag value, or empty if no id is set
+static char node_tag[sizeof(",node=") + 2 * NODE_ID_MAX];
+#endif
+
+static udp_exporter_stats_t stats;
+static atomic_uint queue_drops = 0;
+
+// Datagram being filled, only touched by the exporter task
+static uint8_t datagram[PAYLOAD_SIZE];
+static size_t used = 0;
+static uint32_t count = 0;
+static uint32_t seq = 0;
+static int64_t base_us = 0;
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static void datagram_begin(const udp_sample_t *first)
+{
+    base_us = first->uptime_us;
+#if CONFIG_UDP_EXPORTER_FORMAT_BINARY
+    datagram[0] = 'S';
+    datagram[1] = 'K';
+    datagram[2] = BIN_VERSION;
+    datagram[3] = 0;
+    put_u32(&datagram[4], seq);
+    put_u32(&datagram[8], (uint32_t)(base_us / 1000));
+    used = BIN_HEADER_SIZE;
+#else
+    // Line protocol parsers skip comment lines
+    used = snprintf((char *)datagram, sizeof(datagram), "# seq=%lu\n", (unsigned long)seq);
+#endif
+}
+
+#if CONFIG_UDP_EXPORTER_FORMAT_BINARY
+static int encode_sample(uint8_t *out, const udp_sample_t *s)
+{
+    // datagram_fits() keeps this within 16 bits
+    uint32_t dt_ms = (uint32_t)((s->uptime_us - base_us) / 1000);
+
+    out[0] = s->channel;
+    out[1] = s->nfields;
+    out[2] = dt_ms;
+    out[3] = dt_ms >> 8;
+    memcpy(&out[4], s->values, s->nfields * sizeof(float));
+    return 4 + s->nfields * sizeof(float);
+}
+#else
+static bool wall_clock_valid(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec > EPOCH_VALID_AFTER;
+}
+
+/**
+ * @brief Build the node tag, escaping the characters line protocol gives a
+ *        meaning to in tag values.
+ */
+static void node_tag_init(void)
+{
+    const char *id = CONFIG_UDP_EXPORTER_NODE_ID;
+    if (!*id) {
+        // An empty tag value is invalid, leave the tag out
+        node_tag[0] = '\0';
+        return;
+    }
+
+    char *p = node_tag + snprintf(node_tag, sizeof(node_tag), ",node=");
+    for (; *id; id++) {
+        if (*id == ',' || *id == ' ' || *id == '=') {
+            *p++ = '\\';
+        }
+        *p++ = *id;
+    }
+    *p = '\0';
+}
+
+/**
+ * @brief Format `channel,node=<id> f1=v1,f2=v2 <epoch ns>`.
+ *
+ * The timestamp is always present: points with the same series and time
+ * overwrite each other, so letting the server stamp a datagram on arrival
+ * would keep only one sample per channel. The exporter task discards
+ * samples until the wall clock is set.
+ */
+static int encode_sample(uint8_t *out, const udp_sample_t *s)
+{
+    const udp_channel_desc_t *ch = &channels[s->channel];
+    char *p = (char *)out;
+    int len = snprintf(p, SAMPLE_TEXT_MAX, "%s%s ", ch->name, node_tag);
+
+    for (int i = 0; i < s->nfields && len < SAMPLE_TEXT_MAX; i++) {
+        len += snprintf(p + len, SAMPLE_TEXT_MAX - len, "%s%s=%.3f",
+                        i ? "," : "", ch->fields[i], s->values[i]);
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t now_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    int64_t at_us = now_us - (esp_timer_get_time() - s->uptime_us);
+    if (len < SAMPLE_TEXT_MAX) {
+        len += snprintf(p + len, SAMPLE_TEXT_MAX - len, " %lld000\n", (long long)at_us);
+    }
+    return len < SAMPLE_TEXT_MAX ? len : -1;
+}
+#endif
+
+#if UDP_EXPORTER_SNTP
+/**
+ * @brief Start SNTP the first time the station gets an address.
+ */
+static void on_got_ip(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    static bool started = false;
+    if (started) {
+        return;
+    }
+    started = true;
+
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_UDP_EXPORTER_SNTP_SERVER);
+    if (esp_netif_sntp_init(&config) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start SNTP, line protocol samples are discarded");
+    }
+}
+#endif
+
+static void datagram_flush(void)
+{
+    if (count == 0) {
+        return;
+    }
+
+#if CONFIG_UDP_EXPORTER_FORMAT_BINARY
+    datagram[BIN_COUNT_OFFSET] = count;
+#endif
+
+    if (!wifi_is_connected()) {
+        stats.dropped += count;
+    } else if (sendto(sock, datagram, used, 0, (struct sockaddr *)&dest, sizeof(dest)) < 0) {
+        stats.send_errors++;
+        stats.dropped += count;
+    } else {
+        stats.datagrams++;
+        stats.bytes += used;
+        stats.samples += count;
+    }
+
+    seq++;
+    used = 0;
+    count = 0;
+}
+
+/**
+ * @brief Whether an encoded sample of `len` bytes still goes into the current datagram.
+ */
+static bool datagram_fits(const udp_sample_t *s, int len)
+{
+#if CONFIG_UDP_EXPORTER_FORMAT_BINARY
+    int64_t dt_us = s->uptime_us - base_us;
+    if (count == UINT8_MAX || dt_us < 0 || dt_us / 1000 > UINT16_MAX) {
+        return false;
+    }
+#endif
+    return used + len <= sizeof(datagram);
+}
+
+static void udp_exporter_task(void *pvParameters)
+{
+    uint8_t encoded[SAMPLE_TEXT_MAX];
+    TickType_t deadline = 0;
+    udp_sample_t s;
+#if CONFIG_UDP_EXPORTER_FORMAT_LINE
+    bool clock_ok = false;
+#endif
+
+    while (1) {
+        TickType_t wait = portMAX_DELAY;
+        if (count > 0) {
+            TickType_t now = xTaskGetTickCount();
+            wait = (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+        }
+
+        if (xQueueReceive(sample_queue, &s, wait) != pdTRUE) {
+            datagram_flush();
+            continue;
+        }
+
+#if CONFIG_UDP_EXPORTER_FORMAT_LINE
+        if (!clock_ok) {
+            // Without a wall clock there is no timestamp to give the point
+            if (!wall_clock_valid()) {
+                stats.unsynced++;
+                continue;
+            }
+            clock_ok = true;
+            ESP_LOGI(TAG, "Wall clock set, exporting (%lu samples discarded before)",
+                     (unsigned long)stats.unsynced);
+        }
+#endif
+
+        if (count == 0) {
+            datagram_begin(&s);
+            deadline = xTaskGetTickCount() + FLUSH_TICKS;
+        }
+
+        int len = encode_sample(encoded, &s);
+        if (len >= 0 && !datagram_fits(&s, len)) {
+            // Doesn't fit (or is too far from the base time): start a new datagram
+            datagram_flush();
+            datagram_begin(&s);
+            deadline = xTaskGetTickCount() + FLUSH_TICKS;
+            len = encode_sample(encoded, &s);
+        }
+        if (len < 0) {
+            // Longer than SAMPLE_TEXT_MAX on its own, no datagram will take it
+            stats.dropped++;
+            continue;
+        }
+
+        memcpy(&datagram[used], encoded, len);
+        used += len;
+        count++;
+    }
+}
+
+esp_err_t udp_exporter_init(void)
+{
+    const char *host = strlen(CONFIG_UDP_EXPORTER_HOST) ? CONFIG_UDP_EXPORTER_HOST : CONFIG_SERVER_IP;
+
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(CONFIG_UDP_EXPORTER_PORT);
+    if (inet_pton(AF_INET, host, &dest.sin_addr) != 1) {
+        ESP_LOGE(TAG, "Invalid target address %s", host);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket");
+        return ESP_FAIL;
+    }
+
+    sample_queue = xQueueCreate(CONFIG_UDP_EXPORTER_QUEUE_LEN, sizeof(udp_sample_t));
+    if (!sample_queue) {
+        close(sock);
+        sock = -1;
+        return ESP_ERR_NO_MEM;
+    }
+
+#if CONFIG_UDP_EXPORTER_FORMAT_LINE
+    node_tag_init();
+#endif
+#if UDP_EXPORTER_SNTP
+    esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &on_got_ip, NULL, NULL);
+#endif
+
+    xTaskCreate(udp_exporter_task, "udp_exporter", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
+    ESP_LOGI(TAG, "Exporting to %s:%d", host, CONFIG_UDP_EXPORTER_PORT);
+    return ESP_OK;
+}
+
+esp_err_t udp_exporter_push(udp_exporter_channel_t channel, const float *values)
+{
+    if (!sample_queue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    udp_sample_t s = {
+        .channel = channel,
+        .nfields = channels[channel].nfields,
+        .uptime_us = esp_timer_get_time(),
+    };
+    memcpy(s.values, values, s.nfields * sizeof(float));
+
+    if (xQueueSend(sample_queue, &s, 0) != pdTRUE) {
+        atomic_fetch_add_explicit(&queue_drops, 1, memory_order_relaxed);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void udp_exporter_get_stats(udp_exporter_stats_t *out)
+{
+    *out = stats;
+    out->dropped += atomic_load_explicit(&queue_drops, memory_order_relaxed);
+}
+
+#if CONFIG_UDP_EXPORTER_BENCHMARK
+#define BENCH_HTTP_POSTS 20
+
+static void udp_exporter_benchmark_task(void *pvParameters)
+{
+    wifi_wait_connected(portMAX_DELAY);
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    // UDP: push as fast as the queue drains, then wait for the last flush
+    udp_exporter_stats_t before, after;
+    udp_exporter_get_stats(&before);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < CONFIG_UDP_EXPORTER_BENCHMARK_SAMPLES; i++) {
+        float v[3] = { i * 0.001f, -i * 0.001f, 1.0f };
+        while (uxQueueSpacesAvailable(sample_queue) == 0) {
+            vTaskDelay(1);
+        }
+        udp_exporter_push(UDP_EXPORTER_CH_ACCEL, v);
+    }
+    do {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        udp_exporter_get_stats(&after);
+    } while (after.samples + after.dropped + after.unsynced
+             - before.samples - before.dropped - before.unsynced
+             < CONFIG_UDP_EXPORTER_BENCHMARK_SAMPLES);
+    int64_t udp_us = esp_timer_get_time() - start;
+    uint32_t udp_samples = after.samples - before.samples;
+
+    // HTTP: one POST per sample, as the TH task does
+    uint32_t http_ok = 0;
+    start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_HTTP_POSTS; i++) {
+        http_ok += send_th_sensor_data() == ESP_OK;
+    }
+    int64_t http_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "UDP:  %lu samples in %lu datagrams, %.1f samples/s",
+             (unsigned long)udp_samples, (unsigned long)(after.datagrams - before.datagrams),
+             udp_samples * 1e6 / udp_us);
+    ESP_LOGI(TAG, "HTTP: %lu/%d posts accepted, %.1f samples/s",
+             (unsigned long)http_ok, BENCH_HTTP_POSTS, BENCH_HTTP_POSTS * 1e6 / http_us);
+    vTaskDelete(NULL);
+}
+
+void udp_exporter_benchmark_start(void)
+{
+    xTaskCreate(udp_exporter_benchmark_task, "udp_bench", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
+}
+#endif
+
+#else // CONFIG_UDP_EXPORTER_ENABLE
+
+esp_err_t udp_exporter_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t udp_exporter_push(udp_exporter_channel_t channel, const float *values)
+{
+    return ESP_ERR_INVALID_STATE;
+}
+
+void udp_exporter_get_stats(udp_exporter_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+#endif // CONFIG_UDP_EXPORTER_ENABLE
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    UDP_EXPORTER_CH_TH,     /*!< temperature, humidity */
+    UDP_EXPORTER_CH_ACCEL,  /*!< x, y, z in g */
+    UDP_EXPORTER_CH_COUNT,
+} udp_exporter_channel_t;
+
+#define UDP_EXPORTER_MAX_FIELDS 3
+
+/**
+ * @brief Start the exporter task and open its socket.
+ *
+ * Samples pushed before this are dropped. Does nothing unless
+ * CONFIG_UDP_EXPORTER_ENABLE is set.
+ */
+esp_err_t udp_exporter_init(void);
+
+/**
+ * @brief Queue one sample for export. Never blocks.
+ *
+ * Samples from all channels are packed into MTU-sized datagrams by the
+ * exporter task, which sends when a datagram is full or the flush interval
+ * has passed.
+ *
+ * @param channel Which channel the values belong to; sets the field count
+ * @param values  Field values in the channel's order
+ * @return ESP_ERR_INVALID_STATE if not started, ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t udp_exporter_push(udp_exporter_channel_t channel, const float *values);
+
+typedef struct {
+    uint32_t samples;       /*!< Samples packed into datagrams */
+    uint32_t datagrams;
+    uint32_t bytes;
+    uint32_t dropped;       /*!< Samples lost to a full queue, while offline or too long to encode */
+    uint32_t send_errors;
+    uint32_t unsynced;      /*!< Line protocol samples discarded before the wall clock was set */
+} udp_exporter_stats_t;
+
+void udp_exporter_get_stats(udp_exporter_stats_t *out);
+
+#if CONFIG_UDP_EXPORTER_BENCHMARK
+/**
+ * @brief Once Wi-Fi is up, time a burst of samples through UDP and through
+ *        the HTTP POST path and log samples/s for both.
+ */
+void udp_exporter_benchmark_start(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+#include <string.h>
+#include "wifi_conn.h"
+#include "sdkconfig.h"
+
+void wifi_conn_init(wifi_conn_t *conn, const wifi_ap_cache_t *cached)
+{
+    memset(conn, 0, sizeof(*conn));
+    conn->state = WIFI_CONN_IDLE;
+    if (cached && cached->valid) {
+        conn->ap = *cached;
+    }
+}
+
+bool wifi_conn_on_start(wifi_conn_t *conn)
+{
+    conn->state = WIFI_CONN_CONNECTING;
+    conn->attempt = 0;
+    conn->use_cached = conn->ap.valid;
+    return conn->use_cached;
+}
+
+uint32_t wifi_conn_on_disconnected(wifi_conn_t *conn, uint32_t random)
+{
+    if (conn->state == WIFI_CONN_CONNECTING && conn->use_cached) {
+        // The AP may have moved channel or been replaced; scan next time
+        conn->use_cached = false;
+    } else if (conn->state == WIFI_CONN_CONNECTED) {
+        // A link that was up a moment ago is most likely still on the same AP
+        conn->use_cached = conn->ap.valid;
+    }
+
+    conn->state = WIFI_CONN_BACKOFF;
+    conn->attempt++;
+    return wifi_conn_backoff_ms(conn->attempt, random);
+}
+
+bool wifi_conn_on_retry(wifi_conn_t *conn)
+{
+    conn->state = WIFI_CONN_CONNECTING;
+    return conn->use_cached;
+}
+
+bool wifi_conn_on_associated(wifi_conn_t *conn, const uint8_t bssid[6], uint8_t channel)
+{
+    bool changed = !conn->ap.valid ||
+                   conn->ap.channel != channel ||
+                   memcmp(conn->ap.bssid, bssid, sizeof(conn->ap.bssid)) != 0;
+
+    memcpy(conn->ap.bssid, bssid, sizeof(conn->ap.bssid));
+    conn->ap.channel = channel;
+    conn->ap.valid = true;
+    return changed;
+}
+
+void wifi_conn_on_got_ip(wifi_conn_t *conn)
+{
+    conn->state = WIFI_CONN_CONNECTED;
+    conn->attempt = 0;
+}
+
+uint32_t wifi_conn_backoff_ms(uint32_t attempt, uint32_t random)
+{
+    uint32_t delay = CONFIG_WIFI_BACKOFF_MIN_MS;
+    for (uint32_t i = 1; i < attempt && delay < CONFIG_WIFI_BACKOFF_MAX_MS; i++) {
+        delay *= 2;
+    }
+    if (delay > CONFIG_WIFI_BACKOFF_MAX_MS) {
+        delay = CONFIG_WIFI_BACKOFF_MAX_MS;
+    }
+
+    uint32_t half = delay / 2;
+    return half + (half ? random % (half + 1) : 0);
+}
+
+const char *wifi_conn_state_name(wifi_conn_state_t state)
+{
+    switch (state) {
+        case WIFI_CONN_IDLE:        return "idle";
+        case WIFI_CONN_CONNECTING:  return "connecting";
+        case WIFI_CONN_CONNECTED:   return "connected";
+        case WIFI_CONN_BACKOFF:     return "backoff";
+        default:                    return "?";
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Connection state machine, kept free of esp_wifi so it can be reasoned
+ * about on its own. wifi_manager.c feeds it driver events; on the Linux
+ * target wifi_sim.c stands in for the driver underneath it.
+ *
+ *   IDLE --start--> CONNECTING --got_ip--> CONNECTED
+ *                      ^   |                   |
+ *                 retry|   |disconnected       |disconnected / lost_ip
+ *                      |   v                   |
+ *                     BACKOFF <----------------'
+ */
+typedef enum {
+    WIFI_CONN_IDLE,
+    WIFI_CONN_CONNECTING,
+    WIFI_CONN_CONNECTED,
+    WIFI_CONN_BACKOFF,
+} wifi_conn_state_t;
+
+/**
+ * @brief Last AP we associated with, used for a targeted reconnect.
+ */
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    bool valid;
+} wifi_ap_cache_t;
+
+typedef struct {
+    wifi_conn_state_t state;
+    uint32_t attempt;       /*!< Failed attempts since the last successful connection */
+    bool use_cached;        /*!< Whether the pending attempt targets the cached AP */
+    wifi_ap_cache_t ap;
+} wifi_conn_t;
+
+/**
+ * @brief Reset the state machine, optionally seeding the AP cache from NVS.
+ */
+void wifi_conn_init(wifi_conn_t *conn, const wifi_ap_cache_t *cached);
+
+/**
+ * @brief The driver started; begin the first attempt.
+ * @return true if the attempt should target the cached BSSID/channel
+ */
+bool wifi_conn_on_start(wifi_conn_t *conn);
+
+/**
+ * @brief An attempt failed or an established link dropped.
+ *
+ * A failed targeted attempt falls back to a full scan for the next one.
+ *
+ * @param random Any 32-bit random value, used for jitter
+ * @return Delay in ms before the next attempt
+ */
+uint32_t wifi_conn_on_disconnected(wifi_conn_t *conn, uint32_t random);
+
+/**
+ * @brief The backoff delay expired; begin the next attempt.
+ * @return true if the attempt should target the cached BSSID/channel
+ */
+bool wifi_conn_on_retry(wifi_conn_t *conn);
+
+/**
+ * @brief Associated with an AP.
+ * @return true if the AP cache changed and should be persisted
+ */
+bool wifi_conn_on_associated(wifi_conn_t *conn, const uint8_t bssid[6], uint8_t channel);
+
+/**
+ * @brief The station obtained an IP address.
+ */
+void wifi_conn_on_got_ip(wifi_conn_t *conn);
+
+/**
+ * @brief Backoff before attempt number `attempt` (1-based).
+ *
+ * Doubles from CONFIG_WIFI_BACKOFF_MIN_MS up to CONFIG_WIFI_BACKOFF_MAX_MS,
+ * then picks uniformly from the upper half of that window so boards that
+ * lost the same AP don't retry in lockstep.
+ */
+uint32_t wifi_conn_backoff_ms(uint32_t attempt, uint32_t random);
+
+/**
+ * @brief Printable state name
+ */
+const char *wifi_conn_state_name(wifi_conn_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,35 +1,170 @@
+#include <string.h>
 #include "wifi_manager.h"
-#include "esp_wifi.h"
+#include "wifi_port.h"
 #include "esp_event.h"
+#include "esp_netif.h"
 #include "esp_log.h"
+#include "nvs.h"
 #include "freertos/event_groups.h"
+#include "freertos/timers.h"
 #include "sdkconfig.h"
+#include "boot_metrics/boot_metrics.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_random.h"
+#endif
 
 static const char *TAG = "wifi_manager";
 static EventGroupHandle_t s_wifi_event_group;
 #define WIFI_CONNECTED_BIT BIT0
 
+#define WIFI_NVS_NAMESPACE  "wifi_conn"
+#define WIFI_NVS_KEY_AP     "ap"
+
+/*
+ * All state machine transitions happen in the default event loop task: the
+ * retry timer only posts WIFI_MANAGER_EVENT_RETRY back to the loop.
+ */
+ESP_EVENT_DEFINE_BASE(WIFI_MANAGER_EVENT);
+enum {
+    WIFI_MANAGER_EVENT_RETRY,
+};
+
+static wifi_conn_t s_conn;
+static wifi_config_t s_wifi_config;
+static TimerHandle_t s_retry_timer;
+
+#if !CONFIG_IDF_TARGET_LINUX
+esp_err_t wifi_port_init(void)
+{
+    esp_netif_create_default_wifi_sta();
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    esp_err_t err = esp_wifi_init(&cfg);
+    if (err == ESP_OK) {
+        err = esp_wifi_set_mode(WIFI_MODE_STA);
+    }
+    return err;
+}
+
+uint32_t wifi_port_random(void)
+{
+    return esp_random();
+}
+#endif
+
+static void load_ap_cache(wifi_ap_cache_t *ap)
+{
+    nvs_handle_t nvs;
+    size_t len = sizeof(*ap);
+
+    memset(ap, 0, sizeof(*ap));
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    if (nvs_get_blob(nvs, WIFI_NVS_KEY_AP, ap, &len) != ESP_OK || len != sizeof(*ap)) {
+        memset(ap, 0, sizeof(*ap));
+    }
+    nvs_close(nvs);
+}
+
+static void save_ap_cache(const wifi_ap_cache_t *ap)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open NVS for AP cache");
+        return;
+    }
+    if (nvs_set_blob(nvs, WIFI_NVS_KEY_AP, ap, sizeof(*ap)) != ESP_OK ||
+        nvs_commit(nvs) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store AP cache");
+    }
+    nvs_close(nvs);
+}
+
+/**
+ * @brief Count a failed attempt or dropped link and arm the retry timer.
+ */
+static void schedule_retry(const char *why)
+{
+    xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+    uint32_t delay_ms = wifi_conn_on_disconnected(&s_conn, wifi_port_random());
+    ESP_LOGI(TAG, "%s, retry %lu in %lu ms", why,
+             (unsigned long)s_conn.attempt, (unsigned long)delay_ms);
+    xTimerChangePeriod(s_retry_timer, pdMS_TO_TICKS(delay_ms), 0);
+}
+
+/**
+ * @brief Point the driver at the cached AP, or let it scan all channels.
+ *
+ * If the driver rejects the request no DISCONNECTED event will follow, so
+ * the failure is fed to the state machine here.
+ */
+static void connect_to(bool use_cached)
+{
+    if (use_cached) {
+        memcpy(s_wifi_config.sta.bssid, s_conn.ap.bssid, sizeof(s_wifi_config.sta.bssid));
+        s_wifi_config.sta.bssid_set = true;
+        s_wifi_config.sta.channel = s_conn.ap.channel;
+        s_wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+        ESP_LOGI(TAG, "Reconnecting to cached AP on channel %d", s_conn.ap.channel);
+    } else {
+        s_wifi_config.sta.bssid_set = false;
+        s_wifi_config.sta.channel = 0;
+        s_wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config);
+    if (err == ESP_OK) {
+        err = esp_wifi_connect();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Connect request failed: %s", esp_err_to_name(err));
+        schedule_retry("Connect failed");
+    }
+}
+
+static void retry_timer_cb(TimerHandle_t timer)
+{
+    esp_event_post(WIFI_MANAGER_EVENT, WIFI_MANAGER_EVENT_RETRY, NULL, 0, 0);
+}
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        connect_to(wifi_conn_on_start(&s_conn));
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *)event_data;
+        if (wifi_conn_on_associated(&s_conn, event->bssid, event->channel)) {
+            save_ap_cache(&s_conn.ap);
+        }
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        esp_wifi_connect();
-        ESP_LOGI(TAG, "Retrying connection...");
+        // Already backing off: this is the disconnect we asked for on lost IP
+        if (s_conn.state != WIFI_CONN_BACKOFF) {
+            schedule_retry("Disconnected");
+        }
+    } else if (event_base == WIFI_MANAGER_EVENT && event_id == WIFI_MANAGER_EVENT_RETRY) {
+        connect_to(wifi_conn_on_retry(&s_conn));
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        wifi_conn_on_got_ip(&s_conn);
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        boot_metrics_mark_got_ip();
         ESP_LOGI(TAG, "Got IP!");
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_LOST_IP) {
+        // DHCP gave up while still associated; drop the link and start over
+        schedule_retry("Lost IP");
+        esp_wifi_disconnect();
     }
 }
 
 esp_err_t wifi_init_sta(void)
 {
     s_wifi_event_group = xEventGroupCreate();
+    s_retry_timer = xTimerCreate("wifi_retry", 1, pdFALSE, NULL, retry_timer_cb);
 
-    esp_netif_create_default_wifi_sta();
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+    wifi_ap_cache_t cached;
+    load_ap_cache(&cached);
+    wifi_conn_init(&s_conn, &cached);
+
+    ESP_ERROR_CHECK(wifi_port_init());
 
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
                                                         ESP_EVENT_ANY_ID,
@@ -41,17 +176,45 @@ esp_err_t wifi_init_sta(void)
                                                         &wifi_event_handler,
                                                         NULL,
                                                         NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+                                                        IP_EVENT_STA_LOST_IP,
+                                                        &wifi_event_handler,
+                                                        NULL,
+                                                        NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_MANAGER_EVENT,
+                                                        WIFI_MANAGER_EVENT_RETRY,
+                                                        &wifi_event_handler,
+                                                        NULL,
+                                                        NULL));
 
-    wifi_config_t wifi_config = {0};
-    strcpy((char *)wifi_config.sta.ssid, CONFIG_WIFI_SSID);
-    strcpy((char *)wifi_config.sta.password, CONFIG_WIFI_PASSWORD);
+    strcpy((char *)s_wifi_config.sta.ssid, CONFIG_WIFI_SSID);
+    strcpy((char *)s_wifi_config.sta.password, CONFIG_WIFI_PASSWORD);
 
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
 
-    // Wait for connection
-    xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
-    ESP_LOGI(TAG, "Wi-Fi connected!");
+    // Association and DHCP continue in the background
+    ESP_LOGI(TAG, "Wi-Fi started, connecting to %s", CONFIG_WIFI_SSID);
     return ESP_OK;
 }
+
+bool wifi_is_connected(void)
+{
+    return s_wifi_event_group &&
+           (xEventGroupGetBits(s_wifi_event_group) & WIFI_CONNECTED_BIT);
+}
+
+bool wifi_wait_connected(TickType_t timeout)
+{
+    if (!s_wifi_event_group) {
+        return false;
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT,
+                                           pdFALSE, pdTRUE, timeout);
+    return bits & WIFI_CONNECTED_BIT;
+}
+
+wifi_conn_state_t wifi_get_state(void)
+{
+    return s_conn.state;
+}
@@ -1,8 +1,32 @@
 #pragma once
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
 #include "esp_err.h"
+#include "wifi_conn.h"
 
 /**
- * @brief Initialize Wi-Fi in STA mode and connect
+ * @brief Initialize Wi-Fi in STA mode and start connecting
+ *
+ * Returns as soon as the driver is started; association and DHCP complete
+ * in the background. Register for IP_EVENT_STA_GOT_IP to attach services
+ * that need the network.
+ *
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t wifi_init_sta(void);
+
+/**
+ * @brief Whether the station currently holds an IP address
+ */
+bool wifi_is_connected(void);
+
+/**
+ * @brief Block until the station has an IP address or the timeout expires
+ * @return true if connected
+ */
+bool wifi_wait_connected(TickType_t timeout);
+
+/**
+ * @brief Current state of the connection manager
+ */
+wifi_conn_state_t wifi_get_state(void);
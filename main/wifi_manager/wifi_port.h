@@ -0,0 +1,89 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "sdkconfig.h"
+
+/*
+ * The part of the Wi-Fi driver wifi_manager.c talks to. On the device this
+ * is esp_wifi. The Linux target has no esp_wifi component, so this header
+ * declares the same names for the subset in use and wifi_sim.c implements
+ * the calls.
+ */
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_wifi.h"
+#else
+
+#define ESP_ERR_WIFI_NOT_STARTED    (ESP_ERR_WIFI_BASE + 2)
+#define ESP_ERR_WIFI_CONN           (ESP_ERR_WIFI_BASE + 7)
+
+typedef enum {
+    WIFI_IF_STA,
+} wifi_interface_t;
+
+typedef enum {
+    WIFI_FAST_SCAN,
+    WIFI_ALL_CHANNEL_SCAN,
+} wifi_scan_method_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    wifi_scan_method_t scan_method;
+    bool bssid_set;
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_sta_config_t;
+
+typedef union {
+    wifi_sta_config_t sta;
+} wifi_config_t;
+
+ESP_EVENT_DECLARE_BASE(WIFI_EVENT);
+
+typedef enum {
+    WIFI_EVENT_STA_START = 2,
+    WIFI_EVENT_STA_CONNECTED = 4,
+    WIFI_EVENT_STA_DISCONNECTED = 5,
+} wifi_event_t;
+
+typedef enum {
+    WIFI_REASON_ASSOC_LEAVE = 8,
+    WIFI_REASON_BEACON_TIMEOUT = 200,
+    WIFI_REASON_NO_AP_FOUND = 201,
+} wifi_err_reason_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+
+#endif // CONFIG_IDF_TARGET_LINUX
+
+/**
+ * @brief Create the station interface and bring the driver up in STA mode.
+ *
+ * Everything short of esp_wifi_set_config()/esp_wifi_start(), which
+ * wifi_manager.c calls itself.
+ */
+esp_err_t wifi_port_init(void);
+
+/**
+ * @brief Random word for backoff jitter.
+ */
+uint32_t wifi_port_random(void);
@@ -0,0 +1,154 @@
+/*
+ * Simulated Wi-Fi driver calls for the Linux target.
+ *
+ * wifi_manager.c runs unchanged on the host. This file implements the
+ * driver calls declared in wifi_port.h, with the types declared there. A
+ * task plays the radio and posts the same WIFI_EVENT/IP_EVENT events the
+ * driver would to the default loop. Association succeeds after a short
+ * delay when the cached AP is targeted and a longer one for a full scan, and
+ * the "AP" goes down for CONFIG_WIFI_SIM_OUTAGE_MS out of every
+ * CONFIG_WIFI_SIM_UPTIME_MS + CONFIG_WIFI_SIM_OUTAGE_MS, so backoff, the
+ * retry timer, the NVS AP cache and pause/resume of the uploader can all be
+ * watched on the host.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "wifi_port.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "wifi_sim";
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+
+static const uint8_t sim_bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+#define SIM_CHANNEL 6
+
+static wifi_sta_config_t s_sta_config;
+static QueueHandle_t s_connect_queue;
+static volatile bool s_disconnect;
+
+static bool ap_is_up(void)
+{
+    int64_t period = CONFIG_WIFI_SIM_UPTIME_MS + CONFIG_WIFI_SIM_OUTAGE_MS;
+    return (esp_timer_get_time() / 1000) % period < CONFIG_WIFI_SIM_UPTIME_MS;
+}
+
+static void post_disconnected(uint8_t reason)
+{
+    wifi_event_sta_disconnected_t event = {
+        .ssid_len = strlen((const char *)s_sta_config.ssid),
+        .reason = reason,
+    };
+    memcpy(event.ssid, s_sta_config.ssid, event.ssid_len);
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &event, sizeof(event), portMAX_DELAY);
+}
+
+/**
+ * @brief Run one association attempt for the config in effect at connect time.
+ * @return true if the station got an address
+ */
+static bool sim_attempt(const wifi_sta_config_t *sta)
+{
+    vTaskDelay(pdMS_TO_TICKS(sta->bssid_set ? CONFIG_WIFI_SIM_FAST_CONNECT_MS
+                                            : CONFIG_WIFI_SIM_SCAN_CONNECT_MS));
+
+    bool reachable = ap_is_up();
+    if (sta->bssid_set &&
+        (memcmp(sta->bssid, sim_bssid, sizeof(sim_bssid)) != 0 || sta->channel != SIM_CHANNEL)) {
+        // A stale cache entry: a targeted scan finds nothing
+        reachable = false;
+    }
+    if (!reachable) {
+        post_disconnected(WIFI_REASON_NO_AP_FOUND);
+        return false;
+    }
+
+    wifi_event_sta_connected_t connected = {
+        .ssid_len = strlen((const char *)sta->ssid),
+        .channel = SIM_CHANNEL,
+    };
+    memcpy(connected.ssid, sta->ssid, connected.ssid_len);
+    memcpy(connected.bssid, sim_bssid, sizeof(sim_bssid));
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected, sizeof(connected), portMAX_DELAY);
+
+    ip_event_got_ip_t got_ip = {
+        .ip_info = {
+            .ip.addr = ESP_IP4TOADDR(127, 0, 0, 1),
+            .netmask.addr = ESP_IP4TOADDR(255, 0, 0, 0),
+        },
+        .ip_changed = true,
+    };
+    esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), portMAX_DELAY);
+    return true;
+}
+
+static void wifi_sim_task(void *pvParameters)
+{
+    wifi_sta_config_t sta;
+
+    while (1) {
+        xQueueReceive(s_connect_queue, &sta, portMAX_DELAY);
+        s_disconnect = false;
+        if (!sim_attempt(&sta)) {
+            continue;
+        }
+
+        while (ap_is_up() && !s_disconnect) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+        ESP_LOGI(TAG, s_disconnect ? "Station left the AP" : "AP went away");
+        post_disconnected(s_disconnect ? WIFI_REASON_ASSOC_LEAVE : WIFI_REASON_BEACON_TIMEOUT);
+    }
+}
+
+esp_err_t wifi_port_init(void)
+{
+    // No netif to create: the host's own stack carries the traffic
+    return ESP_OK;
+}
+
+uint32_t wifi_port_random(void)
+{
+    return (uint32_t)random();
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (interface != WIFI_IF_STA || !conf) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_sta_config = conf->sta;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    if (!s_connect_queue) {
+        s_connect_queue = xQueueCreate(1, sizeof(wifi_sta_config_t));
+        xTaskCreate(wifi_sim_task, "wifi_sim", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
+    }
+    ESP_LOGI(TAG, "Simulated station started");
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, portMAX_DELAY);
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    if (!s_connect_queue) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    // Like the driver, refuse a second connect while one is in progress
+    return xQueueSend(s_connect_queue, &s_sta_config, 0) == pdTRUE ? ESP_OK : ESP_ERR_WIFI_CONN;
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    s_disconnect = true;
+    return ESP_OK;
+}
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+Render deferred log records shipped with CONFIG_DLOG_OUTPUT_BINARY.
+
+The firmware prints each record as a "#dl:<hex>" line holding the addresses
+of its format string and tag plus the raw argument words. This script looks
+those addresses up in the application ELF and formats the record the way the
+text drain would. All other lines pass through unchanged.
+
+    idf.py monitor | python3 tools/dlog_decode.py build/esp32_sensorkit.elf
+    python3 tools/dlog_decode.py build/esp32_sensorkit.elf < capture.log
+
+Needs pyelftools, which the ESP-IDF Python environment already provides.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.constants import SH_FLAGS
+from elftools.elf.elffile import ELFFile
+
+PREFIX = "#dl:"
+LEVELS = "NEWIDV"
+ARG_INT, ARG_UINT, ARG_FLOAT, ARG_STR = range(4)
+
+# printf conversion; length modifiers are dropped since arguments are 32-bit
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|L|q|j|z|t)?([diouxXeEfFgGaAcspn%])")
+
+
+class Image:
+    """Read-only view of the allocated sections of an ELF."""
+
+    def __init__(self, path):
+        self.sections = []
+        with open(path, "rb") as f:
+            elf = ELFFile(f)
+            for section in elf.iter_sections():
+                flags = section["sh_flags"]
+                if not flags & SH_FLAGS.SHF_ALLOC or section["sh_type"] == "SHT_NOBITS":
+                    continue
+                self.sections.append((section["sh_addr"], section.data()))
+
+    def string(self, addr):
+        for base, data in self.sections:
+            if base <= addr < base + len(data):
+                end = data.find(b"\0", addr - base)
+                if end < 0:
+                    end = len(data)
+                return data[addr - base:end].decode("utf-8", "replace")
+        return "<0x%08x>" % addr
+
+
+def format_record(image, fmt, types, words):
+    args = iter(zip(types, words))
+
+    def convert(match):
+        flags, conv = match.groups()
+        if conv == "%":
+            return "%"
+        try:
+            kind, word = next(args)
+        except StopIteration:
+            return "?"
+        if kind == ARG_STR:
+            return ("%" + flags + "s") % image.string(word) if conv == "s" else "?"
+        if kind == ARG_FLOAT:
+            value = struct.unpack("<f", struct.pack("<I", word))[0]
+            return ("%" + flags + conv) % value if conv in "eEfFgG" else "?"
+        if conv in "eEfFgGaAsn":
+            return "?"
+        if conv == "p":
+            return "0x%x" % word
+        if conv == "c":
+            return chr(word & 0xff)
+        # Like the device: the conversion decides signedness, not the stored type
+        if conv in "di":
+            word = word - (1 << 32) if word & 0x80000000 else word
+        return ("%" + flags + ("d" if conv in "diu" else conv)) % word
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode_line(image, line):
+    payload = bytes.fromhex(line[len(PREFIX):].strip())
+    fmt_addr, tag_addr, ms, level, nargs, type_bits = struct.unpack_from("<IIIBBB", payload)
+    words = struct.unpack_from("<%dI" % nargs, payload, 15)
+    types = [(type_bits >> (2 * i)) & 0x3 for i in range(nargs)]
+
+    text = format_record(image, image.string(fmt_addr), types, words)
+    level_char = LEVELS[level] if level < len(LEVELS) else "N"
+    return "%s (%d) %s: %s" % (level_char, ms, image.string(tag_addr), text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("elf", help="application ELF the device is running")
+    parser.add_argument("input", nargs="?", type=argparse.FileType("r", errors="replace"),
+                        default=sys.stdin, help="console log (default: stdin)")
+    args = parser.parse_args()
+
+    image = Image(args.elf)
+    for line in args.input:
+        start = line.find(PREFIX)
+        if start < 0:
+            sys.stdout.write(line)
+        else:
+            try:
+                decoded = decode_line(image, line[start:])
+            except (ValueError, struct.error):
+                sys.stdout.write(line)
+                continue
+            sys.stdout.write(line[:start] + decoded + "\n")
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
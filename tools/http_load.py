@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Host-side load generator for the SensorKit HTTP server.
+
+Opens N keep-alive connections against the device (or the Linux-target build
+running on this machine) and has each one issue requests back to back for a
+fixed duration. Reports requests/s, latency percentiles and, via /stats, how
+many sessions the server purged to make room for new clients.
+
+    python3 tools/http_load.py --host 127.0.0.1 --port 8000 -c 16 -d 10
+    python3 tools/http_load.py -c 32 --path /th_sensor:4 --path /hello:1 --path /nodes:1
+
+A path may carry a weight as `path:weight`. Streaming (chunked) responses are
+read to the end, so their latency is time-to-last-byte.
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import time
+
+
+class Stats:
+    def __init__(self):
+        self.latencies = []
+        self.errors = 0
+        self.reconnects = 0
+        self.status = {}
+
+
+async def read_response(reader):
+    """Read one HTTP/1.1 response, returning (status, keep_alive)."""
+    status_line = await reader.readline()
+    if not status_line:
+        raise ConnectionError("connection closed")
+    status = int(status_line.split()[1])
+
+    headers = {}
+    while True:
+        line = await reader.readline()
+        if line in (b"\r\n", b"\n", b""):
+            break
+        name, _, value = line.decode("latin-1").partition(":")
+        headers[name.strip().lower()] = value.strip()
+
+    if headers.get("transfer-encoding", "").lower() == "chunked":
+        while True:
+            size = int((await reader.readline()).split(b";")[0], 16)
+            await reader.readexactly(size + 2)
+            if size == 0:
+                break
+    else:
+        length = int(headers.get("content-length", "0"))
+        if length:
+            await reader.readexactly(length)
+
+    return status, headers.get("connection", "").lower() != "close"
+
+
+async def worker(args, paths, weights, deadline, stats):
+    reader = writer = None
+    while time.monotonic() < deadline:
+        path = random.choices(paths, weights)[0]
+        request = (f"GET {path} HTTP/1.1\r\nHost: {args.host}\r\n"
+                   f"Connection: keep-alive\r\n\r\n").encode()
+        try:
+            if writer is None:
+                reader, writer = await asyncio.wait_for(
+                    asyncio.open_connection(args.host, args.port), args.timeout)
+            start = time.perf_counter()
+            writer.write(request)
+            await writer.drain()
+            status, keep_alive = await asyncio.wait_for(read_response(reader), args.timeout)
+            stats.latencies.append(time.perf_counter() - start)
+            stats.status[status] = stats.status.get(status, 0) + 1
+        except (OSError, ConnectionError, asyncio.TimeoutError,
+                asyncio.IncompleteReadError, ValueError, IndexError):
+            # Purged or dropped sessions surface here as resets / EOF
+            stats.errors += 1
+            keep_alive = False
+        if not keep_alive and writer is not None:
+            writer.close()
+            writer = None
+            stats.reconnects += 1
+    if writer is not None:
+        writer.close()
+
+
+def dechunk(body):
+    """Undo chunked transfer encoding."""
+    out = b""
+    while True:
+        size_line, body = body.split(b"\r\n", 1)
+        size = int(size_line.split(b";", 1)[0], 16)
+        if size == 0:
+            return out
+        out += body[:size]
+        body = body[size + 2:]
+
+
+async def fetch_server_stats(args):
+    try:
+        reader, writer = await asyncio.wait_for(
+            asyncio.open_connection(args.host, args.port), args.timeout)
+        writer.write(f"GET /stats HTTP/1.1\r\nHost: {args.host}\r\n"
+                     f"Connection: close\r\n\r\n".encode())
+        data = await asyncio.wait_for(reader.read(), args.timeout)
+        writer.close()
+        head, body = data.split(b"\r\n\r\n", 1)
+        if b"transfer-encoding: chunked" in head.lower():
+            body = dechunk(body)
+        return json.loads(body)
+    except (OSError, asyncio.TimeoutError, ValueError, IndexError):
+        return None
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return float("nan")
+    index = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[index]
+
+
+async def run(args):
+    paths, weights = [], []
+    for spec in args.path or ["/th_sensor", "/hello"]:
+        path, _, weight = spec.partition(":")
+        paths.append(path)
+        weights.append(float(weight) if weight else 1.0)
+
+    before = await fetch_server_stats(args)
+    stats = Stats()
+    start = time.monotonic()
+    deadline = start + args.duration
+    await asyncio.gather(*(worker(args, paths, weights, deadline, stats)
+                           for _ in range(args.concurrency)))
+    elapsed = time.monotonic() - start
+    after = await fetch_server_stats(args)
+
+    lat = sorted(stats.latencies)
+    print(f"target       {args.host}:{args.port}  paths {dict(zip(paths, weights))}")
+    print(f"concurrency  {args.concurrency}  duration {elapsed:.1f} s")
+    print(f"requests     {len(lat)}  ({len(lat) / elapsed:.1f} req/s)")
+    print(f"status       {dict(sorted(stats.status.items()))}")
+    print(f"errors       {stats.errors}  reconnects {stats.reconnects}")
+    print("latency ms   p50 {:.2f}  p99 {:.2f}  p999 {:.2f}  max {:.2f}".format(
+        *(1000 * percentile(lat, p) for p in (50, 99, 99.9, 100))))
+    if before and after:
+        print("server       opened {}  closed {}  purged {}  (max_open_sockets {})".format(
+            after["opened"] - before["opened"], after["closed"] - before["closed"],
+            after["purged"] - before["purged"], after["max_open_sockets"]))
+    else:
+        print("server       /stats unavailable")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("-c", "--concurrency", type=int, default=8)
+    parser.add_argument("-d", "--duration", type=float, default=10.0, help="seconds")
+    parser.add_argument("-t", "--timeout", type=float, default=5.0, help="per request, seconds")
+    parser.add_argument("-p", "--path", action="append", help="path[:weight], repeatable")
+    asyncio.run(run(parser.parse_args()))
+
+
+if __name__ == "__main__":
+    main()
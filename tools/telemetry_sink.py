@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+Local sink for SensorKit telemetry, to benchmark the UDP exporter against
+the HTTP POST path.
+
+Listens for UDP datagrams (line protocol or binary framing, auto-detected)
+and for HTTP POSTs on /th_sensor, and prints per-second and total rates.
+Lost datagrams are counted from gaps in the sequence numbers.
+
+    python3 tools/telemetry_sink.py --udp-port 8089 --http-port 8000
+"""
+
+import argparse
+import socket
+import struct
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+class Counters:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.datagrams = 0
+        self.udp_samples = 0
+        self.udp_bytes = 0
+        self.lost = 0
+        self.last_seq = None
+        self.posts = 0
+        self.http_bytes = 0
+
+    def snapshot(self):
+        with self.lock:
+            return (self.datagrams, self.udp_samples, self.udp_bytes,
+                    self.lost, self.posts, self.http_bytes)
+
+
+def parse_datagram(data):
+    """Return (seq, samples) for either framing."""
+    if data[:2] == b"SK":
+        _, version, count, seq, _base_ms = struct.unpack_from("<2sBBII", data)
+        return seq, count
+    lines = data.decode("utf-8", "replace").splitlines()
+    seq = None
+    if lines and lines[0].startswith("# seq="):
+        seq = int(lines[0][6:])
+    return seq, sum(1 for line in lines if line and not line.startswith("#"))
+
+
+def udp_loop(port, counters, verbose):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sock.bind(("0.0.0.0", port))
+    while True:
+        data, _ = sock.recvfrom(65535)
+        seq, samples = parse_datagram(data)
+        with counters.lock:
+            counters.datagrams += 1
+            counters.udp_samples += samples
+            counters.udp_bytes += len(data)
+            if seq is not None:
+                if counters.last_seq is not None and seq > counters.last_seq + 1:
+                    counters.lost += seq - counters.last_seq - 1
+                counters.last_seq = seq
+        if verbose:
+            print(data.decode("utf-8", "replace") if data[:2] != b"SK" else data.hex())
+
+
+def http_server(port, counters):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def do_POST(self):
+            body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+            with counters.lock:
+                counters.posts += 1
+                counters.http_bytes += len(body)
+            self.send_response(200)
+            self.send_header("Content-Length", "2")
+            self.end_headers()
+            self.wfile.write(b"OK")
+
+        def log_message(self, *args):
+            pass
+
+    ThreadingHTTPServer(("0.0.0.0", port), Handler).serve_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--udp-port", type=int, default=8089)
+    parser.add_argument("--http-port", type=int, default=8000, help="0 to disable")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print datagrams")
+    args = parser.parse_args()
+
+    counters = Counters()
+    threading.Thread(target=udp_loop, args=(args.udp_port, counters, args.verbose), daemon=True).start()
+    if args.http_port:
+        threading.Thread(target=http_server, args=(args.http_port, counters), daemon=True).start()
+
+    prev = counters.snapshot()
+    try:
+        while True:
+            time.sleep(1)
+            cur = counters.snapshot()
+            d = [c - p for c, p in zip(cur, prev)]
+            if any(d):
+                print(f"udp {d[1]:6d} samples/s in {d[0]:4d} datagrams ({d[2]:7d} B/s), lost {cur[3]}"
+                      f" | http {d[4]:4d} posts/s ({d[5]:6d} B/s)")
+            prev = cur
+    except KeyboardInterrupt:
+        cur = counters.snapshot()
+        print(f"\ntotal: udp {cur[1]} samples / {cur[0]} datagrams / {cur[2]} B, "
+              f"lost {cur[3]} datagrams; http {cur[4]} posts / {cur[5]} B")
+
+
+if __name__ == "__main__":
+    main()